@@ -0,0 +1,337 @@
+// Hand evaluator benchmark and verification.
+//
+//   ./bench [--hands N] [--exhaustive] [--reference] [--threads N]
+//
+// By default, times every evaluator on N random 5, 6 and 7-card hands and checks that they agree,
+// then checks EquityCalculator::exact on known matchups at several thread counts.
+// --exhaustive walks all 133,784,560 seven-card hands. It checks the hand-class counts against
+// the known distribution, and checks that evaluateStrength and evaluateMask produce the same
+// ordering. --reference also compares the map-based evaluateHandReference on every hand.
+// That check is slow.
+
+#include "poker.h"
+#include "equity.h"
+#include <iostream>
+#include <iomanip>
+#include <chrono>
+#include <thread>
+#include <atomic>
+#include <functional>
+#include <algorithm>
+#include <cmath>
+
+static const int NUM_RANKS = 10;
+
+// Seven-card hand-class counts over all C(52,7) hands (straight flush excludes royal)
+static const uint64_t EXPECTED_COUNTS[NUM_RANKS] = {
+    23294460, 58627800, 31433400, 6461620, 6180020, 4047644, 3473184, 224848, 37260, 4324
+};
+
+struct RandomHands {
+    std::vector<std::vector<Card>> cards;
+    std::vector<CardMask> masks;
+};
+
+static RandomHands makeHands(int numCards, int count, uint64_t seed) {
+    RandomHands hands;
+    Xoshiro256 rng(seed);
+    for(int h = 0; h < count; h++) {
+        std::array<CardIndex, 52> deck;
+        for(int i = 0; i < 52; i++) {
+            deck[i] = static_cast<CardIndex>(i);
+        }
+        std::vector<Card> cards;
+        CardMask mask = 0;
+        for(int i = 0; i < numCards; i++) {
+            std::swap(deck[i], deck[i + rng.below(52 - i)]);
+            cards.push_back(cardFromIndex(deck[i]));
+            mask |= cardIndexMask(deck[i]);
+        }
+        hands.cards.push_back(cards);
+        hands.masks.push_back(mask);
+    }
+    return hands;
+}
+
+// Run one evaluator over every hand and print hands/sec; the checksum keeps the work observable
+static void timeEvaluator(const std::string& name, int count, const std::function<uint64_t(int)>& eval) {
+    uint64_t checksum = 0;
+    int passes = 0;
+    auto started = std::chrono::steady_clock::now();
+    double elapsed = 0;
+    do {
+        for(int i = 0; i < count; i++) {
+            checksum += eval(i);
+        }
+        passes++;
+        elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - started).count();
+    } while(elapsed < 0.5);
+
+    double rate = static_cast<double>(count) * passes / elapsed;
+    std::cout << "  " << std::left << std::setw(26) << name << std::right << std::fixed << std::setprecision(2)
+              << std::setw(10) << rate / 1e6 << " M hands/s  " << std::setw(8) << std::setprecision(1)
+              << 1e9 / rate << " ns/hand   (checksum " << std::hex << (checksum & 0xFFFF) << std::dec << ")"
+              << std::endl;
+}
+
+static bool benchmarkRandom(int count) {
+    Poker poker(makeDeckRng(RngKind::FAST));
+    bool ok = true;
+
+    for(int numCards = 5; numCards <= 7; numCards++) {
+        RandomHands hands = makeHands(numCards, count, 0x5EED0000 + numCards);
+        std::cout << numCards << "-card hands (" << count << " random):" << std::endl;
+
+        timeEvaluator("evaluateHand", count, [&](int i) {
+            return static_cast<uint64_t>(poker.evaluateHand(hands.cards[i]));
+        });
+        timeEvaluator("evaluateHandDetailed", count, [&](int i) {
+            return static_cast<uint64_t>(poker.evaluateHandDetailed(hands.cards[i]).strength);
+        });
+        timeEvaluator("evaluateHandReference", count, [&](int i) {
+            return static_cast<uint64_t>(poker.evaluateHandReference(hands.cards[i]).strength);
+        });
+        timeEvaluator("evaluateHandStrength", count, [&](int i) {
+            return static_cast<uint64_t>(poker.evaluateHandStrength(hands.cards[i]));
+        });
+        timeEvaluator("evaluateMask", count, [&](int i) {
+            return static_cast<uint64_t>(Poker::evaluateMask(hands.masks[i]).strength);
+        });
+        timeEvaluator("evaluateStrength", count, [&](int i) {
+            return static_cast<uint64_t>(Poker::evaluateStrength(hands.masks[i]));
+        });
+
+        // Every evaluator must agree with the reference on category and ordering
+        int mismatches = 0;
+        for(int i = 0; i < count; i++) {
+            Poker::HandValue reference = poker.evaluateHandReference(hands.cards[i]);
+            HandStrength strength = Poker::evaluateStrength(hands.masks[i]);
+            bool agree = Poker::evaluateMask(hands.masks[i]) == reference
+                && poker.evaluateHandDetailed(hands.cards[i]) == reference
+                && poker.evaluateHand(hands.cards[i]) == reference.rank
+                && Poker::strengthToHandRank(strength) == reference.rank;
+            if(i > 0) {
+                Poker::HandValue prev = poker.evaluateHandReference(hands.cards[i - 1]);
+                HandStrength prevStrength = Poker::evaluateStrength(hands.masks[i - 1]);
+                agree = agree && ((reference > prev) == (strength > prevStrength))
+                              && ((reference == prev) == (strength == prevStrength));
+            }
+            if(!agree) {
+                mismatches++;
+            }
+        }
+        if(mismatches > 0) {
+            std::cout << "  MISMATCH: evaluators disagree on " << mismatches << " hands" << std::endl;
+            ok = false;
+        }
+        std::cout << std::endl;
+    }
+    return ok;
+}
+
+// Preflop all-in equity of the first hand, from published exact enumerations
+struct Matchup {
+    const char* name;
+    std::vector<std::vector<Card>> hands;
+    double equity;
+};
+
+static bool checkEquity() {
+    const std::vector<Matchup> matchups = {
+        {"AsAh vs KsKd", {{Card(Rank::Ace, Suit::Spades), Card(Rank::Ace, Suit::Hearts)},
+                          {Card(Rank::King, Suit::Spades), Card(Rank::King, Suit::Diamonds)}}, 0.8195},
+        {"AhKh vs QsQc", {{Card(Rank::Ace, Suit::Hearts), Card(Rank::King, Suit::Hearts)},
+                          {Card(Rank::Queen, Suit::Spades), Card(Rank::Queen, Suit::Clubs)}}, 0.4621},
+    };
+    bool ok = true;
+
+    std::cout << "Exact equity (heads-up preflop):" << std::endl;
+    for(const auto& matchup : matchups) {
+        auto start = std::chrono::steady_clock::now();
+        EquityResult single = EquityCalculator(1).exact(matchup.hands, {}, {});
+        double elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+        bool agree = single.runouts == 1712304 && std::fabs(single.equity[0] - matchup.equity) < 0.0005;
+        // Integer counters merged in order: every thread count must give identical results
+        for(int threads : {2, 3, 8}) {
+            EquityResult split = EquityCalculator(threads).exact(matchup.hands, {}, {});
+            agree = agree && split.win == single.win && split.tie == single.tie && split.runouts == single.runouts;
+        }
+        std::cout << "  " << std::left << std::setw(16) << matchup.name << std::right << std::fixed
+                  << std::setprecision(4) << std::setw(8) << single.equity[0]
+                  << "  (expected " << matchup.equity << ")  " << std::setprecision(1)
+                  << elapsed * 1e3 << " ms" << std::defaultfloat << std::endl;
+        if(!agree) {
+            std::cout << "  MISMATCH: " << matchup.name << std::endl;
+            ok = false;
+        }
+    }
+    std::cout << std::endl;
+    return ok;
+}
+
+// Per-thread tallies for the exhaustive walk
+struct alignas(64) ExhaustiveTotals {
+    uint64_t counts[NUM_RANKS] = {};
+    uint64_t mismatches = 0;
+    uint64_t referenceMismatches = 0;
+    std::vector<uint32_t> valueOf;   // HandValue.strength + 1 seen for each HandStrength (0 = unseen)
+};
+
+static bool runExhaustive(int numThreads, bool withReference) {
+    if(numThreads <= 0) {
+        numThreads = std::max(1u, std::thread::hardware_concurrency());
+    }
+    std::cout << "Exhaustive 7-card walk (" << numThreads << " threads"
+              << (withReference ? ", with reference evaluator" : "") << ")" << std::endl;
+
+    std::vector<ExhaustiveTotals> totals(numThreads);
+    std::atomic<int> nextTop(51);
+
+    // Threads claim the highest card of the hand, largest (most work) first
+    auto work = [&](int id) {
+        ExhaustiveTotals& mine = totals[id];
+        mine.valueOf.assign(1 << 16, 0);
+        Poker poker(makeDeckRng(RngKind::FAST));
+        std::vector<Card> cards(7, cardFromIndex(0));
+
+        for(int g = nextTop--; g >= 6; g = nextTop--) {
+            CardMask mg = cardIndexMask(g);
+            for(int f = 5; f < g; f++) {
+                CardMask mf = mg | cardIndexMask(f);
+                for(int e = 4; e < f; e++) {
+                    CardMask me = mf | cardIndexMask(e);
+                    for(int d = 3; d < e; d++) {
+                        CardMask md = me | cardIndexMask(d);
+                        for(int c = 2; c < d; c++) {
+                            CardMask mc = md | cardIndexMask(c);
+                            for(int b = 1; b < c; b++) {
+                                CardMask mb = mc | cardIndexMask(b);
+                                for(int a = 0; a < b; a++) {
+                                    CardMask hand = mb | cardIndexMask(a);
+                                    HandStrength strength = Poker::evaluateStrength(hand);
+                                    Poker::HandValue value = Poker::evaluateMask(hand);
+                                    HandRank rank = Poker::strengthToHandRank(strength);
+                                    mine.counts[static_cast<int>(rank)]++;
+
+                                    uint32_t& seen = mine.valueOf[strength];
+                                    if(rank != value.rank || (seen != 0 && seen != value.strength + 1)) {
+                                        mine.mismatches++;
+                                    }
+                                    seen = value.strength + 1;
+
+                                    if(withReference) {
+                                        const int idx[7] = {a, b, c, d, e, f, g};
+                                        for(int k = 0; k < 7; k++) {
+                                            cards[k] = cardFromIndex(static_cast<CardIndex>(idx[k]));
+                                        }
+                                        if(!(poker.evaluateHandReference(cards) == value)) {
+                                            mine.referenceMismatches++;
+                                        }
+                                    }
+                                }
+                            }
+                        }
+                    }
+                }
+            }
+        }
+    };
+
+    auto started = std::chrono::steady_clock::now();
+    std::vector<std::thread> threads;
+    for(int t = 1; t < numThreads; t++) {
+        threads.emplace_back(work, t);
+    }
+    work(0);
+    for(auto& thread : threads) {
+        thread.join();
+    }
+    double elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - started).count();
+
+    // Merge the tallies and the strength -> HandValue map
+    uint64_t counts[NUM_RANKS] = {};
+    uint64_t mismatches = 0;
+    uint64_t referenceMismatches = 0;
+    std::vector<uint32_t> valueOf(1 << 16, 0);
+    for(const auto& t : totals) {
+        for(int r = 0; r < NUM_RANKS; r++) {
+            counts[r] += t.counts[r];
+        }
+        mismatches += t.mismatches;
+        referenceMismatches += t.referenceMismatches;
+        for(size_t s = 0; s < valueOf.size(); s++) {
+            if(t.valueOf[s] == 0) {
+                continue;
+            }
+            if(valueOf[s] != 0 && valueOf[s] != t.valueOf[s]) {
+                mismatches++;
+            }
+            valueOf[s] = t.valueOf[s];
+        }
+    }
+
+    // Ordering agreement: walking strengths upward must give strictly increasing HandValues
+    int distinct = 0;
+    uint32_t previous = 0;
+    for(size_t s = 0; s < valueOf.size(); s++) {
+        if(valueOf[s] == 0) {
+            continue;
+        }
+        if(valueOf[s] <= previous) {
+            mismatches++;
+        }
+        previous = valueOf[s];
+        distinct++;
+    }
+
+    bool ok = true;
+    uint64_t total = 0;
+    Poker names;
+    for(int r = 0; r < NUM_RANKS; r++) {
+        bool match = counts[r] == EXPECTED_COUNTS[r];
+        ok = ok && match;
+        total += counts[r];
+        std::cout << "  " << std::left << std::setw(18) << names.handRankToString(static_cast<HandRank>(r))
+                  << std::right << std::setw(12) << counts[r] << (match ? "" : "  expected " + std::to_string(EXPECTED_COUNTS[r]))
+                  << std::endl;
+    }
+    std::cout << "  " << std::left << std::setw(18) << "Total" << std::right << std::setw(12) << total << std::endl;
+    std::cout << "  Distinct hand values: " << distinct << (distinct == 4824 ? "" : " (expected 4824)") << std::endl;
+    std::cout << "  evaluateStrength vs evaluateMask mismatches: " << mismatches << std::endl;
+    if(withReference) {
+        std::cout << "  evaluateHandReference mismatches: " << referenceMismatches << std::endl;
+    }
+    std::cout << std::fixed << std::setprecision(2) << "  " << elapsed << "s, "
+              << total / elapsed / 1e6 << " M hands/s" << std::endl;
+
+    return ok && distinct == 4824 && mismatches == 0 && referenceMismatches == 0;
+}
+
+int main(int argc, char* argv[]) {
+    int count = 200000;
+    int threads = 0;
+    bool exhaustive = false;
+    bool withReference = false;
+
+    for(int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        if(arg == "--hands" && i + 1 < argc) {
+            count = std::stoi(argv[++i]);
+        } else if(arg == "--threads" && i + 1 < argc) {
+            threads = std::stoi(argv[++i]);
+        } else if(arg == "--exhaustive") {
+            exhaustive = true;
+        } else if(arg == "--reference") {
+            withReference = true;
+        } else {
+            std::cerr << "Usage: " << argv[0] << " [--hands N] [--exhaustive] [--reference] [--threads N]" << std::endl;
+            return 1;
+        }
+    }
+
+    bool ok = exhaustive ? runExhaustive(threads, withReference)
+                         : benchmarkRandom(std::max(count, 1)) && checkEquity();
+    std::cout << (ok ? "PASS" : "FAIL") << std::endl;
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,64 @@
+#include "compact.h"
+
+namespace compact {
+
+const char* const STAGE_NAMES[6] = {"WAITING", "PREFLOP", "FLOP", "TURN", "RIVER", "SHOWDOWN"};
+
+uint8_t stageCode(const std::string& stage) {
+    for (uint8_t i = 0; i < 6; i++) {
+        if (stage == STAGE_NAMES[i]) {
+            return i;
+        }
+    }
+    return 0;
+}
+
+void put(std::string& out, uint8_t value) {
+    out.push_back(static_cast<char>(value));
+}
+
+void put(std::string& out, uint64_t value) {
+    while (value >= 0x80) {
+        out.push_back(static_cast<char>((value & 0x7F) | 0x80));
+        value >>= 7;
+    }
+    out.push_back(static_cast<char>(value));
+}
+
+void put(std::string& out, const std::string& value) {
+    size_t length = value.size() < 255 ? value.size() : 255;
+    out.push_back(static_cast<char>(length));
+    out.append(value, 0, length);
+}
+
+bool get(Reader& in, uint8_t& value) {
+    if (in.at == in.end) {
+        return false;
+    }
+    value = *in.at++;
+    return true;
+}
+
+bool get(Reader& in, uint64_t& value) {
+    value = 0;
+    for (int shift = 0; shift < 64 && in.at != in.end; shift += 7) {
+        uint8_t byte = *in.at++;
+        value |= static_cast<uint64_t>(byte & 0x7F) << shift;
+        if (!(byte & 0x80)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+bool get(Reader& in, std::string& value) {
+    uint8_t length;
+    if (!get(in, length) || in.end - in.at < length) {
+        return false;
+    }
+    value.assign(reinterpret_cast<const char*>(in.at), length);
+    in.at += length;
+    return true;
+}
+
+} // namespace compact
@@ -0,0 +1,209 @@
+#ifndef COMPACT_H
+#define COMPACT_H
+
+#include <string>
+#include <cstdint>
+#include <cstddef>
+#include "poker.h"
+
+// Compact binary protocol for bot clients on the TCP port, chosen with the 'B' flag byte.
+// Frames keep the 4-byte length prefix; a body is a 1-byte tag followed by the message's fields
+// in schema order. Bodies starting with '{' are JSON, so messages outside the schema (REGISTER,
+// JOIN_GAME, their responses, ...) still travel as JSON on the same connection.
+//
+// Field encodings:
+//   uint8_t    one byte: seats (0xFF = none), stages, actions, hand ranks, flags, cards
+//   uint64_t   unsigned LEB128 varint: ids, sequence numbers, chip amounts
+//   string     length byte, then the bytes (at most 255)
+//   List<T, N> count byte, then count elements (at most N)
+//
+// A card is one byte, (rank - 2) * 4 + suit. Stages are numbered as in STAGE_NAMES, actions as
+// in ActionType, hand ranks as in HandRank and turn results as in TurnResult (0 = accepted).
+//
+// Encoders and decoders are generated from the schema below; adding a message is one entry.
+namespace compact {
+
+const uint8_t NO_SEAT = 0xFF;
+const uint8_t SEAT_ACTIVE = 1;
+const uint8_t SEAT_HAS_HAND = 2;
+const size_t MAX_SEATS = 9;
+
+extern const char* const STAGE_NAMES[6];    // WAITING, PREFLOP, FLOP, TURN, RIVER, SHOWDOWN
+
+inline uint8_t cardCode(const Card& card) {
+    return static_cast<uint8_t>((static_cast<int>(card.rank) - 2) * 4 + static_cast<int>(card.suit));
+}
+
+// Index into STAGE_NAMES, or 0 (WAITING) for an unknown name
+uint8_t stageCode(const std::string& stage);
+
+struct Reader {
+    const uint8_t* at;
+    const uint8_t* end;
+};
+
+void put(std::string& out, uint8_t value);
+void put(std::string& out, uint64_t value);
+void put(std::string& out, const std::string& value);
+bool get(Reader& in, uint8_t& value);
+bool get(Reader& in, uint64_t& value);
+bool get(Reader& in, std::string& value);
+
+// Fixed-capacity list, so decoding never allocates for lists of numbers
+template <typename T, size_t N>
+struct List {
+    uint8_t count = 0;
+    T items[N];
+
+    void push(const T& item) { if (count < N) items[count++] = item; }
+};
+
+template <typename T, size_t N>
+void put(std::string& out, const List<T, N>& list) {
+    put(out, list.count);
+    for (uint8_t i = 0; i < list.count; i++) {
+        put(out, list.items[i]);
+    }
+}
+
+template <typename T, size_t N>
+bool get(Reader& in, List<T, N>& list) {
+    if (!get(in, list.count) || list.count > N) {
+        return false;
+    }
+    for (uint8_t i = 0; i < list.count; i++) {
+        if (!get(in, list.items[i])) {
+            return false;
+        }
+    }
+    return true;
+}
+
+using Cards = List<uint8_t, 7>;
+
+// A record is a struct plus its put/get, all expanded from one field list
+#define COMPACT_DECLARE(type, name) type name{};
+#define COMPACT_PUT(type, name) put(out, record.name);
+#define COMPACT_GET(type, name) && get(in, record.name)
+
+#define COMPACT_RECORD(Name, FIELDS, ...)                                   \
+    struct Name {                                                           \
+        __VA_ARGS__                                                         \
+        FIELDS(COMPACT_DECLARE)                                             \
+    };                                                                      \
+    inline void put(std::string& out, const Name& record) {                 \
+        (void)out; (void)record;                                            \
+        FIELDS(COMPACT_PUT)                                                 \
+    }                                                                       \
+    inline bool get(Reader& in, Name& record) {                             \
+        (void)in; (void)record;                                             \
+        return true FIELDS(COMPACT_GET);                                    \
+    }
+
+#define COMPACT_MESSAGE(Name, tag, FIELDS) \
+    COMPACT_RECORD(Name, FIELDS, static const uint8_t TAG = tag;)
+
+// ---- Schema ----
+
+#define SEAT_STATE_FIELDS(F)        \
+    F(uint64_t, chips)              \
+    F(uint64_t, currentBet)         \
+    F(uint8_t, flags)
+
+#define SEAT_INFO_FIELDS(F)         \
+    F(std::string, username)        \
+    F(uint64_t, chips)              \
+    F(uint64_t, currentBet)         \
+    F(uint8_t, flags)
+
+#define WINNER_FIELDS(F)            \
+    F(uint8_t, seat)                \
+    F(uint8_t, handRank)            \
+    F(uint64_t, chipsWon)           \
+    F(uint64_t, totalChips)
+
+#define SHOWN_HAND_FIELDS(F)        \
+    F(uint8_t, seat)                \
+    F(uint8_t, handRank)            \
+    F(Cards, cards)
+
+#define PLAY_TURN_FIELDS(F)         \
+    F(uint64_t, gameId)             \
+    F(uint8_t, seat)                \
+    F(uint8_t, action)              \
+    F(uint64_t, amount)
+
+#define PLAY_TURN_RESPONSE_FIELDS(F)            \
+    F(uint64_t, gameId)                         \
+    F(uint8_t, result)                          \
+    F(uint64_t, amount)
+
+#define GAME_STARTED_FIELDS(F)                  \
+    F(uint64_t, gameId)                         \
+    F(uint64_t, seq)                            \
+    F(uint8_t, yourSeat)                        \
+    F(Cards, holeCards)                         \
+    F(uint8_t, buttonSeat)                      \
+    F(uint8_t, smallBlindSeat)                  \
+    F(uint8_t, bigBlindSeat)                    \
+    F(uint64_t, pot)                            \
+    F(uint64_t, currentBet)                     \
+    F(uint8_t, currentSeat)                     \
+    F(SeatInfoList, seats)
+
+#define GAME_STATE_FIELDS(F)                    \
+    F(uint64_t, gameId)                         \
+    F(uint64_t, seq)                            \
+    F(uint8_t, stage)                           \
+    F(uint64_t, pot)                            \
+    F(uint64_t, currentBet)                     \
+    F(uint8_t, currentSeat)                     \
+    F(Cards, board)                             \
+    F(SeatStateList, seats)
+
+#define SHOWDOWN_FIELDS(F)                      \
+    F(uint64_t, gameId)                         \
+    F(uint64_t, pot)                            \
+    F(Cards, board)                             \
+    F(WinnerList, winners)                      \
+    F(ShownHandList, hands)                     \
+    F(ChipList, chips)
+
+COMPACT_RECORD(SeatState, SEAT_STATE_FIELDS)
+COMPACT_RECORD(SeatInfo, SEAT_INFO_FIELDS)
+COMPACT_RECORD(Winner, WINNER_FIELDS)
+COMPACT_RECORD(ShownHand, SHOWN_HAND_FIELDS)
+
+using SeatStateList = List<SeatState, MAX_SEATS>;
+using SeatInfoList = List<SeatInfo, MAX_SEATS>;
+using WinnerList = List<Winner, MAX_SEATS>;
+using ShownHandList = List<ShownHand, MAX_SEATS>;
+using ChipList = List<uint64_t, MAX_SEATS>;
+
+COMPACT_MESSAGE(PlayTurn, 1, PLAY_TURN_FIELDS)          // Client -> server
+COMPACT_MESSAGE(GameStarted, 2, GAME_STARTED_FIELDS)
+COMPACT_MESSAGE(GameState, 3, GAME_STATE_FIELDS)        // Replaces GAME_STATE_UPDATE
+COMPACT_MESSAGE(Showdown, 4, SHOWDOWN_FIELDS)
+COMPACT_MESSAGE(PlayTurnResponse, 5, PLAY_TURN_RESPONSE_FIELDS)  // Amount: chips moved, or the minimum
+
+// ---- Framing ----
+
+template <typename Message>
+std::string encode(const Message& message) {
+    std::string out;
+    out.push_back(static_cast<char>(Message::TAG));
+    put(out, message);
+    return out;
+}
+
+// Decodes a whole body (tag included); false if the tag differs or the body is malformed
+template <typename Message>
+bool decode(const uint8_t* data, size_t length, Message& message) {
+    Reader in{data, data + length};
+    uint8_t tag;
+    return get(in, tag) && tag == Message::TAG && get(in, message) && in.at == in.end;
+}
+
+} // namespace compact
+
+#endif // COMPACT_H
@@ -0,0 +1,38 @@
+#ifndef CONFIG_H
+#define CONFIG_H
+
+#include <cstddef>
+
+enum class IoBackend {
+    EPOLL,
+    URING       // io_uring; falls back to epoll when the kernel lacks what it needs
+};
+
+// Runtime settings for the server, filled from the command line in main.cpp
+struct ServerConfig {
+    int tcpPort = 8080;
+    int wsPort = 8081;
+    int ioThreads = 0;          // Reactor threads; 0 picks min(4, hardware threads)
+    IoBackend io = IoBackend::EPOLL;
+
+    // Outbound backpressure: a client whose queue would pass either cap, or whose pending output
+    // makes no progress for slowConsumerMs, is disconnected (0 disables the timeout)
+    size_t maxQueuedBytes = 4 * 1024 * 1024;
+    size_t maxQueuedMessages = 4096;
+    int slowConsumerMs = 10000;
+
+    // Low-latency mode: client sockets get TCP_NODELAY, and what a handler sends is written out
+    // together when it returns rather than message by message
+    bool lowLatency = false;
+
+    // A WebSocket client that has not completed its HTTP upgrade this long after connecting is
+    // disconnected (0 disables the timeout)
+    int handshakeTimeoutMs = 5000;
+
+    // permessage-deflate for WebSocket clients that offer it: zlib level (0 turns it off) and the
+    // largest window (log2 bytes, 9-15) our side uses. Smaller windows cost less memory per client.
+    int wsDeflateLevel = 6;
+    int wsDeflateWindowBits = 15;
+};
+
+#endif // CONFIG_H
@@ -0,0 +1,199 @@
+#include "deflate.h"
+#include <zlib.h>
+#include <algorithm>
+#include <cctype>
+#include <stdexcept>
+#include <vector>
+
+static const unsigned char FLUSH_MARKER[4] = {0x00, 0x00, 0xFF, 0xFF};
+
+// Hash table scaled with the window: zlib's default for a full window, less for small ones
+static int memLevelFor(int windowBits) {
+    return std::max(1, std::min(8, windowBits - 7));
+}
+
+static std::string trim(const std::string& s, size_t start, size_t end) {
+    while (start < end && (s[start] == ' ' || s[start] == '\t')) start++;
+    while (end > start && (s[end - 1] == ' ' || s[end - 1] == '\t')) end--;
+    return s.substr(start, end - start);
+}
+
+static std::vector<std::string> split(const std::string& s, char separator) {
+    std::vector<std::string> parts;
+    size_t start = 0;
+    while (start <= s.size()) {
+        size_t end = s.find(separator, start);
+        if (end == std::string::npos) end = s.size();
+        parts.push_back(trim(s, start, end));
+        start = end + 1;
+    }
+    return parts;
+}
+
+// Window size parameter value: 8 to 15, possibly quoted
+static bool parseWindowBits(std::string value, int& bits) {
+    if (value.size() >= 2 && value.front() == '"' && value.back() == '"') {
+        value = value.substr(1, value.size() - 2);
+    }
+    if (value.size() < 1 || value.size() > 2 || !std::all_of(value.begin(), value.end(), ::isdigit)) {
+        return false;
+    }
+    bits = std::stoi(value);
+    return bits >= 8 && bits <= 15;
+}
+
+std::string negotiateDeflate(const std::string& offers, int maxWindowBits, DeflateParams& params) {
+    for (const std::string& offer : split(offers, ',')) {
+        std::vector<std::string> parts = split(offer, ';');
+        if (parts[0] != "permessage-deflate") {
+            continue;
+        }
+
+        DeflateParams accepted;
+        accepted.serverWindowBits = maxWindowBits;
+        bool clientWindowOffered = false;
+        int clientWindowBits = DEFLATE_MAX_WINDOW_BITS;
+        bool seen[4] = {};
+        bool ok = true;
+        for (size_t i = 1; i < parts.size() && ok; i++) {
+            size_t eq = parts[i].find('=');
+            std::string name = trim(parts[i], 0, std::min(eq, parts[i].size()));
+            std::string value = eq == std::string::npos ? "" : trim(parts[i], eq + 1, parts[i].size());
+            int bits;
+            if (name == "server_no_context_takeover" && eq == std::string::npos && !seen[0]) {
+                accepted.serverNoContextTakeover = seen[0] = true;
+            } else if (name == "client_no_context_takeover" && eq == std::string::npos && !seen[1]) {
+                seen[1] = true;     // The client's own business; our inflater copes either way
+            } else if (name == "server_max_window_bits" && !seen[2] && parseWindowBits(value, bits)) {
+                seen[2] = true;
+                ok = bits >= DEFLATE_MIN_WINDOW_BITS;
+                accepted.serverWindowBits = std::min(accepted.serverWindowBits, bits);
+            } else if (name == "client_max_window_bits" && !seen[3] &&
+                       (eq == std::string::npos || parseWindowBits(value, clientWindowBits))) {
+                seen[3] = clientWindowOffered = true;
+            } else {
+                ok = false;     // Unknown, repeated or malformed: decline this offer
+            }
+        }
+        if (!ok) {
+            continue;
+        }
+
+        std::string response = "permessage-deflate";
+        if (accepted.serverNoContextTakeover) {
+            response += "; server_no_context_takeover";
+        }
+        if (accepted.serverWindowBits < DEFLATE_MAX_WINDOW_BITS) {
+            response += "; server_max_window_bits=" + std::to_string(accepted.serverWindowBits);
+        }
+        // A client that lets us limit its window gets the same limit as ours
+        if (clientWindowOffered) {
+            accepted.clientWindowBits = std::min(clientWindowBits, maxWindowBits);
+            response += "; client_max_window_bits=" + std::to_string(accepted.clientWindowBits);
+        }
+        params = accepted;
+        return response;
+    }
+    return "";
+}
+
+Deflater::Deflater(int level, int windowBits) : stream(new z_stream()), compressionLevel(level) {
+    if (deflateInit2(stream.get(), level, Z_DEFLATED, -windowBits, memLevelFor(windowBits),
+                     Z_DEFAULT_STRATEGY) != Z_OK) {
+        throw std::runtime_error("deflateInit2 failed");
+    }
+}
+
+Deflater::~Deflater() {
+    deflateEnd(stream.get());
+}
+
+void Deflater::compress(const char* data, size_t length, std::string& out, bool lastPart) {
+    stream->next_in = reinterpret_cast<Bytef*>(const_cast<char*>(data));
+    stream->avail_in = static_cast<uInt>(length);
+    size_t written = out.size();
+    size_t room = deflateBound(stream.get(), length) + 16;
+    do {
+        out.resize(written + room);
+        stream->next_out = reinterpret_cast<Bytef*>(&out[written]);
+        stream->avail_out = static_cast<uInt>(room);
+        ::deflate(stream.get(), Z_SYNC_FLUSH);
+        written = out.size() - stream->avail_out;
+        room = 1024;
+    } while (stream->avail_out == 0);
+    out.resize(lastPart ? written - sizeof(FLUSH_MARKER) : written);
+}
+
+void Deflater::reset() {
+    deflateReset(stream.get());
+}
+
+void deflateStandalone(const char* data, size_t length, int level, int windowBits,
+                       std::string& out, bool lastPart) {
+    thread_local std::unique_ptr<Deflater> streams[DEFLATE_MAX_WINDOW_BITS + 1];
+    std::unique_ptr<Deflater>& deflater = streams[windowBits];
+    if (!deflater || deflater->level() != level) {
+        deflater.reset(new Deflater(level, windowBits));
+    } else {
+        deflater->reset();
+    }
+    deflater->compress(data, length, out, lastPart);
+}
+
+Inflater::Inflater(int windowBits) : stream(new z_stream()) {
+    if (inflateInit2(stream.get(), -windowBits) != Z_OK) {
+        throw std::runtime_error("inflateInit2 failed");
+    }
+}
+
+Inflater::~Inflater() {
+    inflateEnd(stream.get());
+}
+
+bool Inflater::inflate(const char* data, size_t length, std::string& out, size_t limit) {
+    out.clear();
+    // The message, then the flush marker the sender stripped
+    const unsigned char* inputs[2] = {reinterpret_cast<const unsigned char*>(data), FLUSH_MARKER};
+    size_t lengths[2] = {length, sizeof(FLUSH_MARKER)};
+    for (int part = 0; part < 2; part++) {
+        stream->next_in = const_cast<Bytef*>(inputs[part]);
+        stream->avail_in = static_cast<uInt>(lengths[part]);
+        while (stream->avail_in > 0) {
+            size_t written = out.size();
+            size_t room = std::max<size_t>(4096, lengths[part] * 2);
+            out.resize(written + room);
+            stream->next_out = reinterpret_cast<Bytef*>(&out[written]);
+            stream->avail_out = static_cast<uInt>(room);
+            int result = ::inflate(stream.get(), Z_SYNC_FLUSH);
+            out.resize(out.size() - stream->avail_out);
+            if (out.size() > limit) {
+                return false;
+            }
+            if (result == Z_STREAM_END) {
+                inflateReset(stream.get());     // Client ended its stream with a final block
+                break;
+            }
+            if (result != Z_OK && !(result == Z_BUF_ERROR && stream->avail_out == 0)) {
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+void DeflateSession::compress(const char* data, size_t length, std::string& out) {
+    if (!deflater) {
+        deflater.reset(new Deflater(level, params.serverWindowBits));
+    } else if (stale) {
+        deflater->reset();
+    }
+    deflater->compress(data, length, out);
+    stale = params.serverNoContextTakeover;
+}
+
+bool DeflateSession::decompress(const char* data, size_t length, std::string& out, size_t limit) {
+    if (!inflater) {
+        inflater.reset(new Inflater(params.clientWindowBits));
+    }
+    return inflater->inflate(data, length, out, limit);
+}
@@ -0,0 +1,94 @@
+#ifndef DEFLATE_H
+#define DEFLATE_H
+
+#include <string>
+#include <memory>
+#include <mutex>
+#include <cstddef>
+
+struct z_stream_s;
+
+// Window sizes (log2 bytes) we compress with. RFC 7692 allows 8, which zlib's raw deflate
+// cannot produce, so offers that insist on it are declined.
+const int DEFLATE_MIN_WINDOW_BITS = 9;
+const int DEFLATE_MAX_WINDOW_BITS = 15;
+
+// permessage-deflate (RFC 7692) as agreed with one WebSocket client
+struct DeflateParams {
+    int serverWindowBits = DEFLATE_MAX_WINDOW_BITS;     // Window of the messages we compress
+    int clientWindowBits = DEFLATE_MAX_WINDOW_BITS;     // Window of the messages the client compresses
+    bool serverNoContextTakeover = false;               // Every message we send starts afresh
+};
+
+// Accepts the first permessage-deflate offer in a Sec-WebSocket-Extensions value that can be
+// honoured with a window of at most maxWindowBits. Returns the response value, or "" to decline.
+std::string negotiateDeflate(const std::string& offers, int maxWindowBits, DeflateParams& params);
+
+// Raw deflate stream. Every compress() ends on a sync flush, so more blocks can follow it; the
+// last part of a message drops the trailing 00 00 ff ff that RFC 7692 has senders strip.
+class Deflater {
+public:
+    Deflater(int level, int windowBits);
+    ~Deflater();
+    Deflater(const Deflater&) = delete;
+    Deflater& operator=(const Deflater&) = delete;
+
+    void compress(const char* data, size_t length, std::string& out, bool lastPart = true);
+    void reset();   // Forget the history, so later output refers to nothing sent before
+
+    int level() const { return compressionLevel; }
+
+private:
+    std::unique_ptr<z_stream_s> stream;
+    int compressionLevel;
+};
+
+// Compresses data with no reference to anything sent before. Any client can inflate the result
+// whatever its context, so one copy can go to many connections. Uses a per-thread stream.
+void deflateStandalone(const char* data, size_t length, int level, int windowBits,
+                       std::string& out, bool lastPart = true);
+
+class Inflater {
+public:
+    explicit Inflater(int windowBits);
+    ~Inflater();
+    Inflater(const Inflater&) = delete;
+    Inflater& operator=(const Inflater&) = delete;
+
+    // Replaces out with one decompressed message; false if it is malformed or inflates past limit
+    bool inflate(const char* data, size_t length, std::string& out, size_t limit);
+
+private:
+    std::unique_ptr<z_stream_s> stream;
+};
+
+// Compression state of one connection that negotiated permessage-deflate. Direct messages are
+// compressed with context takeover; room broadcasts are compressed once with deflateStandalone.
+// A standalone message in between puts data in the client's window that this context has not
+// seen, so the context restarts after one (which also keeps coalescing a standalone message safe).
+class DeflateSession {
+public:
+    DeflateSession(const DeflateParams& params, int level) : params(params), level(level) {}
+
+    const DeflateParams params;
+    const int level;
+
+    // Held by senders from compressing a message until it is queued, so the client receives
+    // messages in the order this context produced them
+    std::mutex lock;
+
+    // Caller holds lock. Compresses one whole message with this connection's context.
+    void compress(const char* data, size_t length, std::string& out);
+    // Caller holds lock. A standalone message has been queued for the client.
+    void queuedStandalone() { stale = true; }
+
+    // Owning loop thread only: one compressed client message, with the connection's own context
+    bool decompress(const char* data, size_t length, std::string& out, size_t limit);
+
+private:
+    std::unique_ptr<Deflater> deflater;     // Made on first use
+    bool stale = false;
+    std::unique_ptr<Inflater> inflater;
+};
+
+#endif // DEFLATE_H
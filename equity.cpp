@@ -0,0 +1,265 @@
+#include "equity.h"
+#include "rng.h"
+#include <thread>
+#include <atomic>
+#include <stdexcept>
+#include <algorithm>
+
+namespace {
+
+// Validated, mask-encoded form of an equity query
+struct EquityInput {
+    int numPlayers = 0;
+    CardMask hole[EquityCalculator::MAX_EQUITY_PLAYERS] = {};
+    CardMask board = 0;
+    int boardCount = 0;
+    CardMask remaining[52] = {};   // Cards still in the deck, one bit each
+    int numRemaining = 0;
+};
+
+// Per-worker counters, cache-line aligned so threads never write to a shared line.
+// splits[p][k] counts boards where player p shared the best hand k ways (k = 1 is a win).
+struct alignas(64) WorkerTotals {
+    uint64_t splits[EquityCalculator::MAX_EQUITY_PLAYERS][EquityCalculator::MAX_EQUITY_PLAYERS + 1] = {};
+    uint64_t runouts = 0;
+};
+
+CardMask addCard(CardMask used, const Card& card) {
+    CardMask bit = cardMask(card);
+    if(used & bit) {
+        throw std::invalid_argument("Duplicate card in equity query");
+    }
+    return used | bit;
+}
+
+EquityInput prepareInput(const std::vector<std::vector<Card>>& holeCards,
+                         const std::vector<Card>& board,
+                         const std::vector<Card>& deadCards) {
+    EquityInput in;
+    if(holeCards.size() < 2 || holeCards.size() > EquityCalculator::MAX_EQUITY_PLAYERS) {
+        throw std::invalid_argument("Equity needs between 2 and 10 players");
+    }
+    if(board.size() == 1 || board.size() == 2 || board.size() > 5) {
+        throw std::invalid_argument("Board must have 0, 3, 4 or 5 cards");
+    }
+
+    CardMask used = 0;
+    in.numPlayers = static_cast<int>(holeCards.size());
+    for(int p = 0; p < in.numPlayers; p++) {
+        if(holeCards[p].size() != 2) {
+            throw std::invalid_argument("Each player needs exactly 2 hole cards");
+        }
+        for(const auto& card : holeCards[p]) {
+            used = addCard(used, card);
+            in.hole[p] |= cardMask(card);
+        }
+    }
+    for(const auto& card : board) {
+        used = addCard(used, card);
+        in.board |= cardMask(card);
+    }
+    in.boardCount = static_cast<int>(board.size());
+    for(const auto& card : deadCards) {
+        used = addCard(used, card);
+    }
+
+    for(int suit = 0; suit < 4; suit++) {
+        for(int rank = 0; rank < 13; rank++) {
+            CardMask bit = 1ULL << (suit * 16 + rank);
+            if(!(used & bit)) {
+                in.remaining[in.numRemaining++] = bit;
+            }
+        }
+    }
+    if(in.numRemaining < 5 - in.boardCount) {
+        throw std::invalid_argument("Not enough cards left to complete the board");
+    }
+    return in;
+}
+
+// Score one complete board given every player's full 7-card mask
+void scoreHands(const CardMask* hands, int numPlayers, WorkerTotals& totals) {
+    HandStrength strengths[EquityCalculator::MAX_EQUITY_PLAYERS];
+    HandStrength best = 0;
+    int numBest = 0;
+    for(int p = 0; p < numPlayers; p++) {
+        strengths[p] = Poker::evaluateStrength(hands[p]);
+        if(strengths[p] > best) {
+            best = strengths[p];
+            numBest = 1;
+        } else if(strengths[p] == best) {
+            numBest++;
+        }
+    }
+    for(int p = 0; p < numPlayers; p++) {
+        if(strengths[p] == best) {
+            totals.splits[p][numBest]++;
+        }
+    }
+    totals.runouts++;
+}
+
+// Visit every way to pick `toPick` more cards from remaining[start..]. Each level ORs one card
+// into every player's mask, so a shared board prefix is combined only once. The masks are the
+// per-prefix rank/suit state; each leaf still runs a full evaluateStrength per player, because
+// reusing more of it did not pay: heads-up preflop takes ~41 ms per 1,712,304 boards on one core,
+// ~30 ms of it in evaluateStrength, and memoizing the last card by rank per 6-card prefix took 45.
+void enumerateBoards(const EquityInput& in, int start, int toPick, const CardMask* prefix, WorkerTotals& totals) {
+    CardMask hands[EquityCalculator::MAX_EQUITY_PLAYERS];
+    for(int i = start; i <= in.numRemaining - toPick; i++) {
+        for(int p = 0; p < in.numPlayers; p++) {
+            hands[p] = prefix[p] | in.remaining[i];
+        }
+        if(toPick == 1) {
+            scoreHands(hands, in.numPlayers, totals);
+        } else {
+            enumerateBoards(in, i + 1, toPick - 1, hands, totals);
+        }
+    }
+}
+
+// Merge worker counters in a fixed order and convert them to fractions
+EquityResult collectResult(const EquityInput& in, const std::vector<WorkerTotals>& workers) {
+    WorkerTotals sum;
+    for(const auto& w : workers) {
+        sum.runouts += w.runouts;
+        for(int p = 0; p < in.numPlayers; p++) {
+            for(int k = 1; k <= in.numPlayers; k++) {
+                sum.splits[p][k] += w.splits[p][k];
+            }
+        }
+    }
+
+    EquityResult result;
+    result.runouts = sum.runouts;
+    result.win.assign(in.numPlayers, 0.0);
+    result.tie.assign(in.numPlayers, 0.0);
+    result.equity.assign(in.numPlayers, 0.0);
+    if(sum.runouts == 0) {
+        return result;
+    }
+
+    double total = static_cast<double>(sum.runouts);
+    for(int p = 0; p < in.numPlayers; p++) {
+        double share = static_cast<double>(sum.splits[p][1]);
+        uint64_t ties = 0;
+        for(int k = 2; k <= in.numPlayers; k++) {
+            ties += sum.splits[p][k];
+            share += static_cast<double>(sum.splits[p][k]) / k;
+        }
+        result.win[p] = sum.splits[p][1] / total;
+        result.tie[p] = ties / total;
+        result.equity[p] = share / total;
+    }
+    return result;
+}
+
+} // namespace
+
+EquityCalculator::EquityCalculator(int numThreads) : numThreads(numThreads) {
+    if(this->numThreads <= 0) {
+        this->numThreads = std::max(1u, std::thread::hardware_concurrency());
+    }
+}
+
+// Monte Carlo equity: every worker owns its RNG, deck copy and counters
+EquityResult EquityCalculator::monteCarlo(const std::vector<std::vector<Card>>& holeCards,
+                                          const std::vector<Card>& board,
+                                          const std::vector<Card>& deadCards,
+                                          uint64_t trials,
+                                          uint64_t seed) const {
+    const EquityInput in = prepareInput(holeCards, board, deadCards);
+    const int missing = 5 - in.boardCount;
+
+    int workers = static_cast<int>(std::min<uint64_t>(numThreads, std::max<uint64_t>(trials, 1)));
+    std::vector<WorkerTotals> totals(workers);
+    std::vector<std::thread> threads;
+
+    auto work = [&in, &totals, missing](int id, uint64_t count, uint64_t workerSeed) {
+        Xoshiro256 rng(workerSeed);
+        WorkerTotals& mine = totals[id];
+        CardMask deck[52];
+        std::copy(in.remaining, in.remaining + in.numRemaining, deck);
+
+        for(uint64_t t = 0; t < count; t++) {
+            // Partial Fisher-Yates: only the cards the board still needs are drawn
+            CardMask runout = in.board;
+            for(int i = 0; i < missing; i++) {
+                int j = i + static_cast<int>(rng.below(in.numRemaining - i));
+                std::swap(deck[i], deck[j]);
+                runout |= deck[i];
+            }
+            CardMask hands[MAX_EQUITY_PLAYERS];
+            for(int p = 0; p < in.numPlayers; p++) {
+                hands[p] = in.hole[p] | runout;
+            }
+            scoreHands(hands, in.numPlayers, mine);
+        }
+    };
+
+    for(int id = 0; id < workers; id++) {
+        uint64_t count = trials / workers + (static_cast<uint64_t>(id) < trials % workers ? 1 : 0);
+        uint64_t workerSeed = seed * 0x100000001B3ULL + id;
+        if(id == workers - 1) {
+            work(id, count, workerSeed);  // The calling thread takes the last share
+        } else {
+            threads.emplace_back(work, id, count, workerSeed);
+        }
+    }
+    for(auto& t : threads) {
+        t.join();
+    }
+
+    return collectResult(in, totals);
+}
+
+// Exact equity: enumerate every runout. Work is split by the first missing board card, handed out
+// dynamically; integer counters make the result independent of the thread count and schedule.
+EquityResult EquityCalculator::exact(const std::vector<std::vector<Card>>& holeCards,
+                                     const std::vector<Card>& board,
+                                     const std::vector<Card>& deadCards) const {
+    const EquityInput in = prepareInput(holeCards, board, deadCards);
+    const int missing = 5 - in.boardCount;
+
+    CardMask start[MAX_EQUITY_PLAYERS];
+    for(int p = 0; p < in.numPlayers; p++) {
+        start[p] = in.hole[p] | in.board;
+    }
+
+    if(missing == 0) {
+        std::vector<WorkerTotals> totals(1);
+        scoreHands(start, in.numPlayers, totals[0]);
+        return collectResult(in, totals);
+    }
+
+    const int numFirstCards = in.numRemaining - missing + 1;
+    int workers = std::min(numThreads, numFirstCards);
+    std::vector<WorkerTotals> totals(workers);
+    std::atomic<int> nextFirstCard(0);
+
+    auto work = [&](int id) {
+        WorkerTotals& mine = totals[id];
+        CardMask prefix[MAX_EQUITY_PLAYERS];
+        for(int first = nextFirstCard++; first < numFirstCards; first = nextFirstCard++) {
+            for(int p = 0; p < in.numPlayers; p++) {
+                prefix[p] = start[p] | in.remaining[first];
+            }
+            if(missing == 1) {
+                scoreHands(prefix, in.numPlayers, mine);
+            } else {
+                enumerateBoards(in, first + 1, missing - 1, prefix, mine);
+            }
+        }
+    };
+
+    std::vector<std::thread> threads;
+    for(int id = 0; id < workers - 1; id++) {
+        threads.emplace_back(work, id);
+    }
+    work(workers - 1);
+    for(auto& t : threads) {
+        t.join();
+    }
+
+    return collectResult(in, totals);
+}
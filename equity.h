@@ -0,0 +1,45 @@
+#ifndef EQUITY_H
+#define EQUITY_H
+
+#include <vector>
+#include <cstdint>
+#include "poker.h"
+
+// Win/tie/equity for each player, in the order the hands were given
+struct EquityResult {
+    std::vector<double> win;     // Fraction of runouts won outright
+    std::vector<double> tie;     // Fraction of runouts split with at least one other player
+    std::vector<double> equity;  // Expected share of the pot
+    uint64_t runouts = 0;        // Number of boards evaluated
+};
+
+// All-in equity engine built on the table evaluator (Poker::evaluateStrength)
+class EquityCalculator {
+public:
+    static const int MAX_EQUITY_PLAYERS = 10;
+
+    // numThreads <= 0 uses every hardware thread
+    explicit EquityCalculator(int numThreads = 0);
+
+    // Sample random runouts of the board. Hole cards must be two cards per player, the board
+    // 0, 3, 4 or 5 cards (as from Poker::getCommunityCards). Results are reproducible for a
+    // given seed and thread count.
+    EquityResult monteCarlo(const std::vector<std::vector<Card>>& holeCards,
+                            const std::vector<Card>& board,
+                            const std::vector<Card>& deadCards,
+                            uint64_t trials,
+                            uint64_t seed = 0) const;
+
+    // Enumerate every remaining runout (e.g. C(48,5) = 1,712,304 boards heads-up preflop).
+    // Deterministic regardless of thread count.
+    EquityResult exact(const std::vector<std::vector<Card>>& holeCards,
+                       const std::vector<Card>& board,
+                       const std::vector<Card>& deadCards) const;
+
+    int getNumThreads() const { return numThreads; }
+
+private:
+    int numThreads;
+};
+
+#endif // EQUITY_H
@@ -0,0 +1,56 @@
+#ifndef INBOUND_H
+#define INBOUND_H
+
+#include <vector>
+#include <algorithm>
+#include <cstring>
+#include <cstddef>
+
+// Bytes received on one connection that the handler has not consumed yet. Messages are parsed
+// where they lie, so the unread bytes are always contiguous: consume() only moves the read
+// position, and the unread tail is moved back to the front when the end runs out of room (or
+// dropped for free once everything has been read), never on every read.
+class InputBuffer {
+public:
+    char* data() { return storage.data() + head; }
+    const char* data() const { return storage.data() + head; }
+    size_t size() const { return tail - head; }
+    bool empty() const { return head == tail; }
+    char operator[](size_t i) const { return storage[head + i]; }
+
+    // Free space after the unread bytes, grown to at least n; receive into it, then commit()
+    char* reserve(size_t n) {
+        if (storage.size() - tail < n) {
+            if (head > 0) {
+                memmove(storage.data(), storage.data() + head, tail - head);
+                tail -= head;
+                head = 0;
+            }
+            if (storage.size() - tail < n) {
+                storage.resize(std::max(storage.size() * 2, tail + n));
+            }
+        }
+        return storage.data() + tail;
+    }
+    size_t room() const { return storage.size() - tail; }
+    void commit(size_t n) { tail += n; }
+
+    void append(const char* bytes, size_t n) {
+        memcpy(reserve(n), bytes, n);
+        commit(n);
+    }
+
+    void consume(size_t n) {
+        head += std::min(n, size());
+        if (head == tail) {
+            head = tail = 0;
+        }
+    }
+
+private:
+    std::vector<char> storage;
+    size_t head = 0;    // First unread byte
+    size_t tail = 0;    // End of the received bytes
+};
+
+#endif // INBOUND_H
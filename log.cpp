@@ -0,0 +1,185 @@
+#include "log.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+
+namespace {
+
+const char* const LEVEL_NAMES[] = {"TRACE", "DEBUG", "INFO", "WARN", "ERROR", "OFF"};
+const char* const CATEGORY_NAMES[] = {"server", "net", "msg", "game"};
+
+// Fixed-size stream buffer; anything past the end of the line is cut off
+class LineBuffer : public std::streambuf {
+public:
+    explicit LineBuffer(size_t capacity) : data(new char[capacity]), capacity(capacity) { reset(); }
+    void reset() { setp(data.get(), data.get() + capacity); }
+    const char* text() const { return pbase(); }
+    size_t length() const { return pptr() - pbase(); }
+
+protected:
+    int_type overflow(int_type ch) override { return traits_type::not_eof(ch); }
+
+private:
+    std::unique_ptr<char[]> data;
+    size_t capacity;
+};
+
+struct LineStream {
+    LineBuffer buffer;
+    std::ostream stream;
+
+    explicit LineStream(size_t capacity) : buffer(capacity), stream(&buffer) {}
+};
+
+LineStream& threadLine() {
+    thread_local LineStream line(Logger::LINE_MAX);
+    return line;
+}
+
+} // namespace
+
+bool parseLogLevel(const std::string& name, LogLevel& level) {
+    for (int i = 0; i <= static_cast<int>(LogLevel::OFF); i++) {
+        if (strcasecmp(name.c_str(), LEVEL_NAMES[i]) == 0) {
+            level = static_cast<LogLevel>(i);
+            return true;
+        }
+    }
+    return false;
+}
+
+bool parseLogCategory(const std::string& name, LogCategory& category) {
+    for (int i = 0; i < static_cast<int>(LogCategory::COUNT); i++) {
+        if (strcasecmp(name.c_str(), CATEGORY_NAMES[i]) == 0) {
+            category = static_cast<LogCategory>(i);
+            return true;
+        }
+    }
+    return false;
+}
+
+// Never destroyed, so threads still running at exit can log safely; exit only stops the writer
+Logger& Logger::instance() {
+    static Logger* logger = [] {
+        Logger* created = new Logger();
+        std::atexit([] { Logger::instance().stop(); });
+        return created;
+    }();
+    return *logger;
+}
+
+Logger::Logger() : ring(new Slot[RING_SIZE]) {
+    for (int i = 0; i < static_cast<int>(LogCategory::COUNT); i++) {
+        sampleEvery[i].store(1);
+        sampleCounter[i].store(0);
+    }
+    for (size_t i = 0; i < RING_SIZE; i++) {
+        ring[i].sequence.store(i, std::memory_order_relaxed);
+    }
+    writer = std::thread(&Logger::run, this);
+}
+
+void Logger::setSampling(LogCategory category, uint32_t every) {
+    sampleEvery[static_cast<int>(category)].store(every, std::memory_order_relaxed);
+}
+
+std::ostream& Logger::begin() {
+    LineStream& line = threadLine();
+    line.buffer.reset();
+    line.stream.clear();
+    return line.stream;
+}
+
+// Bounded multi-producer ring (Vyukov): a producer claims a position with a CAS, fills the slot and
+// publishes it through the slot's sequence number
+void Logger::commit(LogLevel level, LogCategory category) {
+    const LineBuffer& line = threadLine().buffer;
+
+    uint64_t pos = enqueuePos.load(std::memory_order_relaxed);
+    Slot* slot;
+    while (true) {
+        slot = &ring[pos & (RING_SIZE - 1)];
+        uint64_t sequence = slot->sequence.load(std::memory_order_acquire);
+        int64_t diff = static_cast<int64_t>(sequence) - static_cast<int64_t>(pos);
+        if (diff == 0) {
+            if (enqueuePos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+                break;
+            }
+        } else if (diff < 0) {
+            dropped.fetch_add(1, std::memory_order_relaxed);   // Full: the writer is behind
+            return;
+        } else {
+            pos = enqueuePos.load(std::memory_order_relaxed);
+        }
+    }
+
+    slot->timeUs = std::chrono::duration_cast<std::chrono::microseconds>(
+        std::chrono::system_clock::now().time_since_epoch()).count();
+    slot->level = level;
+    slot->category = category;
+    slot->length = static_cast<uint16_t>(std::min(line.length(), LINE_MAX));
+    memcpy(slot->text, line.text(), slot->length);
+    slot->sequence.store(pos + 1, std::memory_order_release);
+}
+
+void Logger::stop() {
+    if (running.exchange(false)) {
+        writer.join();
+    }
+}
+
+void Logger::run() {
+    while (running.load(std::memory_order_relaxed)) {
+        if (!drain()) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(2));
+        }
+    }
+    drain();
+}
+
+// Write out every ready line; WARN and above go to stderr. Returns false if there was nothing.
+bool Logger::drain() {
+    std::string out;
+    std::string err;
+    while (true) {
+        Slot& slot = ring[dequeuePos & (RING_SIZE - 1)];
+        if (slot.sequence.load(std::memory_order_acquire) != dequeuePos + 1) {
+            break;
+        }
+
+        time_t seconds = static_cast<time_t>(slot.timeUs / 1000000);
+        struct tm local;
+        localtime_r(&seconds, &local);
+        char prefix[64];
+        size_t n = strftime(prefix, sizeof(prefix), "%Y-%m-%d %H:%M:%S", &local);
+        snprintf(prefix + n, sizeof(prefix) - n, ".%03d %-5s [%s] ",
+                 static_cast<int>(slot.timeUs / 1000 % 1000),
+                 LEVEL_NAMES[static_cast<int>(slot.level)],
+                 CATEGORY_NAMES[static_cast<int>(slot.category)]);
+
+        std::string& target = slot.level >= LogLevel::WARN ? err : out;
+        target += prefix;
+        target.append(slot.text, slot.length);
+        target += '\n';
+
+        slot.sequence.store(dequeuePos + RING_SIZE, std::memory_order_release);
+        dequeuePos++;
+    }
+
+    uint64_t lost = dropped.exchange(0, std::memory_order_relaxed);
+    if (lost > 0) {
+        err += "[log] " + std::to_string(lost) + " lines dropped, log ring full\n";
+    }
+    if (!out.empty()) {
+        fwrite(out.data(), 1, out.size(), stdout);
+        fflush(stdout);
+    }
+    if (!err.empty()) {
+        fwrite(err.data(), 1, err.size(), stderr);
+        fflush(stderr);
+    }
+    return !out.empty() || !err.empty();
+}
@@ -0,0 +1,107 @@
+#ifndef LOG_H
+#define LOG_H
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <ostream>
+#include <string>
+#include <thread>
+
+enum class LogLevel {
+    TRACE,
+    DEBUG,
+    INFO,
+    WARN,
+    ERROR,
+    OFF
+};
+
+// What a line is about; sampling is set per category
+enum class LogCategory {
+    SERVER,     // Startup and configuration
+    NET,        // Connections and the I/O backends
+    MSG,        // Per-message tracing
+    GAME,       // Table events
+    COUNT
+};
+
+bool parseLogLevel(const std::string& name, LogLevel& level);
+bool parseLogCategory(const std::string& name, LogCategory& category);
+
+// Asynchronous logger. A caller formats its line into a thread-local buffer and pushes it onto a
+// bounded lock-free ring; a background thread writes lines out in batches. When the ring is full
+// the line is dropped (and counted) instead of blocking the caller. Use the LOG_* macros, which
+// only evaluate their message when the line will actually be kept.
+class Logger {
+public:
+    static Logger& instance();
+
+    void setLevel(LogLevel level) { minLevel.store(level, std::memory_order_relaxed); }
+    LogLevel level() const { return minLevel.load(std::memory_order_relaxed); }
+    // Keep one line in every `every` of a category below WARN (1 keeps all)
+    void setSampling(LogCategory category, uint32_t every);
+
+    bool enabled(LogLevel level, LogCategory category) {
+        if (level < minLevel.load(std::memory_order_relaxed)) {
+            return false;
+        }
+        int c = static_cast<int>(category);
+        uint32_t every = sampleEvery[c].load(std::memory_order_relaxed);
+        return every <= 1 || level >= LogLevel::WARN ||
+               sampleCounter[c].fetch_add(1, std::memory_order_relaxed) % every == 0;
+    }
+
+    // The calling thread's line buffer, emptied; commit() queues what was written to it
+    static std::ostream& begin();
+    void commit(LogLevel level, LogCategory category);
+
+    // Write out everything queued and stop the writer thread (runs at exit)
+    void stop();
+
+    static constexpr size_t LINE_MAX = 480;     // Longer lines are cut off
+
+private:
+    static constexpr size_t RING_SIZE = 4096;   // Power of two
+
+    struct Slot {
+        std::atomic<uint64_t> sequence;     // == position + 1 once the line at position is ready
+        int64_t timeUs;
+        LogLevel level;
+        LogCategory category;
+        uint16_t length;
+        char text[LINE_MAX];
+    };
+
+    std::atomic<LogLevel> minLevel{LogLevel::INFO};
+    std::atomic<uint32_t> sampleEvery[static_cast<int>(LogCategory::COUNT)];
+    std::atomic<uint32_t> sampleCounter[static_cast<int>(LogCategory::COUNT)];
+
+    std::unique_ptr<Slot[]> ring;
+    alignas(64) std::atomic<uint64_t> enqueuePos{0};
+    alignas(64) uint64_t dequeuePos = 0;    // Writer thread only
+    std::atomic<uint64_t> dropped{0};
+    std::atomic<bool> running{true};
+    std::thread writer;
+
+    Logger();
+    void run();
+    bool drain();
+};
+
+#define LOG(level, category, ...)                                           \
+    do {                                                                    \
+        Logger& logger_ = Logger::instance();                               \
+        if (logger_.enabled(level, category)) {                             \
+            Logger::begin() << __VA_ARGS__;                                 \
+            logger_.commit(level, category);                                \
+        }                                                                   \
+    } while (0)
+
+#define LOG_TRACE(category, ...) LOG(LogLevel::TRACE, LogCategory::category, __VA_ARGS__)
+#define LOG_DEBUG(category, ...) LOG(LogLevel::DEBUG, LogCategory::category, __VA_ARGS__)
+#define LOG_INFO(category, ...)  LOG(LogLevel::INFO, LogCategory::category, __VA_ARGS__)
+#define LOG_WARN(category, ...)  LOG(LogLevel::WARN, LogCategory::category, __VA_ARGS__)
+#define LOG_ERROR(category, ...) LOG(LogLevel::ERROR, LogCategory::category, __VA_ARGS__)
+
+#endif // LOG_H
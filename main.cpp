@@ -1,11 +1,84 @@
 #include "server.h"
+#include "log.h"
+#include "deflate.h"
+
+static void printUsage(const char* program) {
+    std::cerr << "Usage: " << program << " [--tcp-port N] [--ws-port N] [--io-threads N] [--io epoll|uring]\n"
+              << "       [--max-queue-bytes N] [--max-queue-messages N] [--slow-consumer-ms N]\n"
+              << "       [--handshake-timeout-ms N] [--ws-deflate-level 0-9] [--ws-deflate-window 9-15] [--low-latency]\n"
+              << "       [--log-level trace|debug|info|warn|error|off] [--log-sample server|net|msg|game=N]" << std::endl;
+}
+
+int main(int argc, char* argv[]) {
+    ServerConfig config;
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        if (arg == "--tcp-port" && i + 1 < argc) {
+            config.tcpPort = std::stoi(argv[++i]);
+        } else if (arg == "--ws-port" && i + 1 < argc) {
+            config.wsPort = std::stoi(argv[++i]);
+        } else if (arg == "--io-threads" && i + 1 < argc) {
+            config.ioThreads = std::stoi(argv[++i]);
+        } else if (arg == "--max-queue-bytes" && i + 1 < argc) {
+            config.maxQueuedBytes = std::stoull(argv[++i]);
+        } else if (arg == "--max-queue-messages" && i + 1 < argc) {
+            config.maxQueuedMessages = std::stoull(argv[++i]);
+        } else if (arg == "--slow-consumer-ms" && i + 1 < argc) {
+            config.slowConsumerMs = std::stoi(argv[++i]);
+        } else if (arg == "--handshake-timeout-ms" && i + 1 < argc) {
+            config.handshakeTimeoutMs = std::stoi(argv[++i]);
+        } else if (arg == "--low-latency") {
+            config.lowLatency = true;
+        } else if (arg == "--ws-deflate-level" && i + 1 < argc) {
+            config.wsDeflateLevel = std::stoi(argv[++i]);
+            if (config.wsDeflateLevel < 0 || config.wsDeflateLevel > 9) {
+                printUsage(argv[0]);
+                return 1;
+            }
+        } else if (arg == "--ws-deflate-window" && i + 1 < argc) {
+            config.wsDeflateWindowBits = std::stoi(argv[++i]);
+            if (config.wsDeflateWindowBits < DEFLATE_MIN_WINDOW_BITS || config.wsDeflateWindowBits > DEFLATE_MAX_WINDOW_BITS) {
+                printUsage(argv[0]);
+                return 1;
+            }
+        } else if (arg == "--log-level" && i + 1 < argc) {
+            LogLevel level;
+            if (!parseLogLevel(argv[++i], level)) {
+                printUsage(argv[0]);
+                return 1;
+            }
+            Logger::instance().setLevel(level);
+        } else if (arg == "--log-sample" && i + 1 < argc) {
+            // Keep one line in N of a chatty category, e.g. --log-sample msg=100
+            std::string spec = argv[++i];
+            size_t eq = spec.find('=');
+            LogCategory category;
+            if (eq == std::string::npos || !parseLogCategory(spec.substr(0, eq), category)) {
+                printUsage(argv[0]);
+                return 1;
+            }
+            Logger::instance().setSampling(category, std::stoul(spec.substr(eq + 1)));
+        } else if ((arg == "--io" && i + 1 < argc) || arg.rfind("--io=", 0) == 0) {
+            std::string backend = (arg == "--io") ? argv[++i] : arg.substr(5);
+            if (backend == "epoll") {
+                config.io = IoBackend::EPOLL;
+            } else if (backend == "uring" || backend == "io_uring") {
+                config.io = IoBackend::URING;
+            } else {
+                printUsage(argv[0]);
+                return 1;
+            }
+        } else {
+            printUsage(argv[0]);
+            return 1;
+        }
+    }
 
-int main() {
     try {
-        Server server;
+        Server server(config);
         server.run();  // This will run forever, accepting clients
     } catch (const std::exception& e) {
-        std::cerr << "Server error: " << e.what() << std::endl;
+        LOG_ERROR(SERVER, "Server error: " << e.what());
         return 1;
     }
     return 0;
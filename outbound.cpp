@@ -0,0 +1,72 @@
+#include "outbound.h"
+
+OutboundQueue::Push OutboundQueue::push(OutboundMessage message, const OutboundLimits& limits) {
+    Push result = Push::QUEUED;
+    if (message.coalesceKey != 0) {
+        // At most one message per key is queued, so the first match from the back is the only one
+        size_t first = frontOffset > 0 ? 1 : 0;
+        for (size_t i = messages.size(); i > first; i--) {
+            if (messages[i - 1].coalesceKey == message.coalesceKey) {
+                totalBytes -= messages[i - 1].size();
+                messages.erase(messages.begin() + (i - 1));
+                result = Push::COALESCED;
+                break;
+            }
+        }
+    }
+
+    size_t size = message.size();
+    if (size == 0) {
+        return result;
+    }
+    if (messages.size() + 1 > limits.maxMessages || size + bytes() > limits.maxBytes) {
+        return Push::OVERFLOW;
+    }
+    messages.push_back(std::move(message));
+    totalBytes += size;
+    return result;
+}
+
+int OutboundQueue::gather(iovec* segments, int max) const {
+    int count = 0;
+    size_t skip = frontOffset;
+    for (auto it = messages.begin(); it != messages.end() && count + 2 <= max; ++it) {
+        const OutboundMessage& message = *it;
+        skip += message.headStart;
+        if (skip < message.head.size()) {
+            segments[count].iov_base = const_cast<char*>(message.head.data() + skip);
+            segments[count].iov_len = message.head.size() - skip;
+            count++;
+            skip = 0;
+        } else {
+            skip -= message.head.size();
+        }
+        if (message.body && skip < message.body->size()) {
+            segments[count].iov_base = const_cast<char*>(message.body->data() + skip);
+            segments[count].iov_len = message.body->size() - skip;
+            count++;
+        }
+        skip = 0;   // Only the front message can be partly written
+    }
+    return count;
+}
+
+void OutboundQueue::consume(size_t n) {
+    while (n > 0 && !messages.empty()) {
+        size_t remaining = messages.front().size() - frontOffset;
+        if (n < remaining) {
+            frontOffset += n;
+            return;
+        }
+        n -= remaining;
+        totalBytes -= messages.front().size();
+        messages.pop_front();
+        frontOffset = 0;
+    }
+}
+
+void OutboundQueue::clear() {
+    messages.clear();
+    frontOffset = 0;
+    totalBytes = 0;
+}
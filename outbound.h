@@ -0,0 +1,62 @@
+#ifndef OUTBOUND_H
+#define OUTBOUND_H
+
+#include <string>
+#include <deque>
+#include <memory>
+#include <cstdint>
+#include <sys/uio.h>
+
+// Segments handed to one sendmsg (the kernel's IOV_MAX): up to 512 queued messages go out in a
+// single call
+const int MAX_GATHER_SEGMENTS = 1024;
+
+// Per-connection caps on queued output; a connection that would exceed them is disconnected
+struct OutboundLimits {
+    size_t maxBytes;
+    size_t maxMessages;
+};
+
+// One message for one connection: a small per-recipient head (length prefix or frame header,
+// plus any private fields) followed by a body that a broadcast shares between all recipients.
+// Either part may be empty.
+struct OutboundMessage {
+    std::string head;
+    std::shared_ptr<const std::string> body;
+    uint64_t coalesceKey = 0;   // Non-zero: a newer queued message with the same key replaces this one
+    size_t headStart = 0;       // Leading bytes of head that are not sent (unused header room)
+
+    size_t size() const { return head.size() - headStart + (body ? body->size() : 0); }
+};
+
+// Messages queued for one connection, kept whole so a stale message can still be replaced.
+// Messages pushed with the same non-zero coalesce key supersede each other: only the newest is
+// kept, at the back of the queue. A message is never replaced once its first byte has been written.
+class OutboundQueue {
+public:
+    enum class Push {
+        QUEUED,
+        COALESCED,      // Queued, and an older message with the same key was dropped
+        OVERFLOW        // Not queued: the limits would be exceeded
+    };
+
+    Push push(OutboundMessage message, const OutboundLimits& limits);
+
+    bool empty() const { return messages.empty(); }
+    size_t size() const { return messages.size(); }
+    size_t bytes() const { return totalBytes - frontOffset; }
+
+    // Unwritten parts of the oldest messages in order, up to max segments (two per message), for
+    // one writev/sendmsg; returns how many were filled in
+    int gather(iovec* segments, int max) const;
+    // Mark n bytes as written, possibly spanning several messages
+    void consume(size_t n);
+    void clear();
+
+private:
+    std::deque<OutboundMessage> messages;
+    size_t frontOffset = 0;     // Bytes of messages.front() already written
+    size_t totalBytes = 0;
+};
+
+#endif // OUTBOUND_H
@@ -4,7 +4,13 @@
 #include <sstream>
 
 // Constructor - Initialize deck and random number generator
-Poker::Poker() : gen(rd()) {
+Poker::Poker() : Poker(makeDeckRng(RngKind::SECURE)) {
+}
+
+Poker::Poker(std::unique_ptr<DeckRng> rng) : dealt(0), rng(std::move(rng)) {
+    for(int i = 0; i < 52; ++i) {
+        deck[i] = static_cast<CardIndex>(i);
+    }
     resetDeck();
 }
 
@@ -13,31 +19,27 @@ Poker::~Poker() {
     // Default destructor
 }
 
-// Reset and shuffle the deck for a new round
+// Start a new round. No shuffle happens here: drawCard picks a uniformly random card from the
+// undrawn part of the deck (a lazy Fisher-Yates step), and since any ordering of the array is a
+// valid starting point, resetting is just rewinding the dealt counter.
 void Poker::resetDeck() {
-    cards.clear();
+    dealt = 0;
     communityCards.clear();
-    
-    // Create all 52 cards in the deck
-    for(int r = static_cast<int>(Rank::Two); r <= static_cast<int>(Rank::Ace); ++r) {
-        for(int s = static_cast<int>(Suit::Hearts); s <= static_cast<int>(Suit::Spades); ++s) {
-            cards.emplace_back(static_cast<Rank>(r), static_cast<Suit>(s));
-        }
-    }
-    
-    // Shuffle the deck
-    std::shuffle(cards.begin(), cards.end(), gen);
 }
 
 // Draw a single card from the deck
-Card Poker::drawCard() {
-    if(cards.empty()) {
+CardIndex Poker::drawCardIndex() {
+    if(dealt >= 52) {
         throw std::runtime_error("No cards left in deck!");
     }
     
-    Card drawnCard = cards.back();
-    cards.pop_back();
-    return drawnCard;
+    int pick = dealt + static_cast<int>(rng->below(52 - dealt));
+    std::swap(deck[dealt], deck[pick]);
+    return deck[dealt++];
+}
+
+Card Poker::drawCard() {
+    return cardFromIndex(drawCardIndex());
 }
 
 // Deal specified number of cards (typically 2 for Texas Hold'em)
@@ -49,43 +51,56 @@ std::vector<Card> Poker::dealCards(int numCards) {
     return hand;
 }
 
+// Deal two hole cards into inline storage
+HoleCards Poker::dealHoleCards() {
+    HoleCards hand;
+    hand.push_back(drawCardIndex());
+    hand.push_back(drawCardIndex());
+    return hand;
+}
+
 // Deal the flop (3 community cards)
 void Poker::dealFlop() {
     // Burn one card (standard poker practice)
-    if(!cards.empty()) {
-        drawCard();
+    if(dealt < 52) {
+        drawCardIndex();
     }
     
     // Deal 3 community cards
     for(int i = 0; i < 3; ++i) {
-        communityCards.push_back(drawCard());
+        communityCards.push_back(drawCardIndex());
     }
 }
 
 // Deal the turn (4th community card)
 void Poker::dealTurn() {
     // Burn one card
-    if(!cards.empty()) {
-        drawCard();
+    if(dealt < 52) {
+        drawCardIndex();
     }
     
     // Deal 1 community card
-    communityCards.push_back(drawCard());
+    communityCards.push_back(drawCardIndex());
 }
 
 // Deal the river (5th community card)
 void Poker::dealRiver() {
     // Burn one card
-    if(!cards.empty()) {
-        drawCard();
+    if(dealt < 52) {
+        drawCardIndex();
     }
     
     // Deal 1 community card
-    communityCards.push_back(drawCard());
+    communityCards.push_back(drawCardIndex());
 }
 
 // Get current community cards
 std::vector<Card> Poker::getCommunityCards() const {
+    return communityCards.toCards();
+}
+
+// Community cards in compact form
+const Board& Poker::getBoard() const {
     return communityCards;
 }
 
@@ -107,80 +122,27 @@ std::map<Suit, int> Poker::countSuits(const std::vector<Card>& hand) const {
     return suitCounts;
 }
 
-// Check if hand contains a flush (5+ cards of same suit)
-bool Poker::isFlush(const std::vector<Card>& hand) const {
-    auto suitCounts = countSuits(hand);
-    for(const auto& pair : suitCounts) {
-        if(pair.second >= 5) {
-            return true;
-        }
-    }
-    return false;
-}
-
-// Check if hand contains a straight (5 consecutive ranks)
-bool Poker::isStraight(const std::vector<Card>& hand) const {
-    std::vector<int> ranks;
-    for(const auto& card : hand) {
-        ranks.push_back(static_cast<int>(card.rank));
-    }
-    
-    // Remove duplicates and sort
-    std::sort(ranks.begin(), ranks.end());
-    ranks.erase(std::unique(ranks.begin(), ranks.end()), ranks.end());
-    
-    // Check for 5 consecutive ranks
-    int consecutive = 1;
-    for(size_t i = 1; i < ranks.size(); ++i) {
-        if(ranks[i] == ranks[i-1] + 1) {
-            consecutive++;
-            if(consecutive >= 5) {
-                return true;
-            }
-        } else {
-            consecutive = 1;
-        }
-    }
-    
-    // Check for Ace-low straight (A-2-3-4-5)
-    if(ranks.size() >= 5) {
-        bool hasAce = (ranks.back() == 14);
-        bool has2 = (ranks[0] == 2);
-        bool has3 = (ranks.size() > 1 && ranks[1] == 3);
-        bool has4 = (ranks.size() > 2 && ranks[2] == 4);
-        bool has5 = (ranks.size() > 3 && ranks[3] == 5);
-        
-        if(hasAce && has2 && has3 && has4 && has5) {
-            return true;
-        }
-    }
-    
-    return false;
-}
-
 // Get the high card of a straight (returns 5 for wheel A-2-3-4-5)
 int getStraightHighCard(const std::vector<int>& sortedRanks) {
     std::vector<int> ranks = sortedRanks;
     std::sort(ranks.begin(), ranks.end());
     ranks.erase(std::unique(ranks.begin(), ranks.end()), ranks.end());
     
-    // Check for regular straight
+    // Check for regular straight (keep the highest run of 5+, not just the last run)
     int consecutive = 1;
-    int highCard = ranks[0];
+    int highCard = 0;
     for(size_t i = 1; i < ranks.size(); ++i) {
         if(ranks[i] == ranks[i-1] + 1) {
             consecutive++;
-            highCard = ranks[i];
             if(consecutive >= 5) {
-                // Continue to find highest possible straight
+                highCard = ranks[i];
             }
         } else {
             consecutive = 1;
-            highCard = ranks[i];
         }
     }
     
-    if(consecutive >= 5) {
+    if(highCard > 0) {
         return highCard;
     }
     
@@ -200,99 +162,32 @@ int getStraightHighCard(const std::vector<int>& sortedRanks) {
 
 // Evaluate a poker hand (player's hole cards + community cards)
 HandRank Poker::evaluateHand(const std::vector<Card>& holeCards) const {
-    // Combine hole cards with community cards
-    std::vector<Card> allCards = holeCards;
-    allCards.insert(allCards.end(), communityCards.begin(), communityCards.end());
-    
-    if(allCards.size() < 5) {
-        // Not enough cards to evaluate
-        return HandRank::HighCard;
-    }
-    
-    // Count ranks
-    auto rankCounts = countRanks(allCards);
-    
-    // Find pairs, trips, quads
-    int pairs = 0;
-    int trips = 0;
-    int quads = 0;
-    
-    for(const auto& pair : rankCounts) {
-        if(pair.second == 4) {
-            quads++;
-        } else if(pair.second == 3) {
-            trips++;
-        } else if(pair.second == 2) {
-            pairs++;
-        }
-    }
-    
-    bool flush = isFlush(allCards);
-    bool straight = isStraight(allCards);
-    
-    // Determine hand rank
-    if(straight && flush) {
-        return HandRank::StraightFlush;
-    }
-    
-    if(quads > 0) {
-        return HandRank::FourOfAKind;
-    }
-    
-    if(trips > 0 && pairs > 0) {
-        return HandRank::FullHouse;
-    }
-    
-    if(flush) {
-        return HandRank::Flush;
-    }
-    
-    if(straight) {
-        return HandRank::Straight;
-    }
-    
-    if(trips > 0) {
-        return HandRank::ThreeOfAKind;
-    }
-    
-    if(pairs >= 2) {
-        return HandRank::TwoPair;
-    }
-    
-    if(pairs == 1) {
-        return HandRank::OnePair;
+    return strengthToHandRank(evaluateHandStrength(holeCards));
+}
+
+// Pack a hand rank and up to five tie-break ranks (most significant first) into a HandValue
+Poker::HandValue Poker::HandValue::pack(HandRank rank, const int* values, int numValues) {
+    HandValue result;
+    result.rank = rank;
+    result.strength = static_cast<uint32_t>(rank) << 20;
+    for(int i = 0; i < numValues && i < 5; i++) {
+        result.strength |= static_cast<uint32_t>(values[i]) << (16 - 4 * i);
     }
-    
-    return HandRank::HighCard;
+    return result;
+}
+
+// Tie-break rank i (0 if the hand has fewer values)
+int Poker::HandValue::value(int i) const {
+    return (strength >> (16 - 4 * i)) & 0xF;
 }
 
 // Compare two hand values
 bool Poker::HandValue::operator>(const HandValue& other) const {
-    // First compare hand rank
-    if(rank != other.rank) {
-        return rank > other.rank;
-    }
-    
-    // Same rank, compare values (kickers)
-    for(size_t i = 0; i < std::min(values.size(), other.values.size()); i++) {
-        if(values[i] != other.values[i]) {
-            return values[i] > other.values[i];
-        }
-    }
-    
-    // All values equal - true tie
-    return false;
+    return strength > other.strength;
 }
 
 bool Poker::HandValue::operator==(const HandValue& other) const {
-    if(rank != other.rank) return false;
-    if(values.size() != other.values.size()) return false;
-    
-    for(size_t i = 0; i < values.size(); i++) {
-        if(values[i] != other.values[i]) return false;
-    }
-    
-    return true;
+    return strength == other.strength;
 }
 
 // Get flush cards for a specific suit
@@ -327,17 +222,19 @@ int getStraightFlushHighCard(const std::vector<Card>& allCards) {
     return bestHigh;
 }
 
-// Detailed hand evaluation with tie-breaking values
-Poker::HandValue Poker::evaluateHandDetailed(const std::vector<Card>& holeCards) const {
-    HandValue result;
+// Reference (map-based) detailed evaluation, kept for cross-checking the bitmask evaluator
+Poker::HandValue Poker::evaluateHandReference(const std::vector<Card>& holeCards) const {
+    HandRank rank = HandRank::HighCard;
+    std::vector<int> values;
     
     // Combine hole cards with community cards
     std::vector<Card> allCards = holeCards;
-    allCards.insert(allCards.end(), communityCards.begin(), communityCards.end());
+    for(const auto& card : communityCards) {
+        allCards.push_back(card);
+    }
     
     if(allCards.size() < 5) {
-        result.rank = HandRank::HighCard;
-        return result;
+        return HandValue::pack(rank, nullptr, 0);
     }
     
     // Count ranks
@@ -394,80 +291,85 @@ Poker::HandValue Poker::evaluateHandDetailed(const std::vector<Card>& holeCards)
     // Determine hand rank and values for comparison
     if(straightFlushHigh > 0) {
         if(straightFlushHigh == 14) {
-            result.rank = HandRank::RoyalFlush;
+            rank = HandRank::RoyalFlush;
         } else {
-            result.rank = HandRank::StraightFlush;
+            rank = HandRank::StraightFlush;
         }
-        result.values.push_back(straightFlushHigh);
+        values.push_back(straightFlushHigh);
     }
     else if(!quads.empty()) {
-        result.rank = HandRank::FourOfAKind;
-        result.values.push_back(quads[0]);  // Quad rank
-        // Add best kicker
-        if(!singles.empty()) result.values.push_back(singles[0]);
-        else if(!trips.empty()) result.values.push_back(trips[0]);
-        else if(!pairs.empty()) result.values.push_back(pairs[0]);
+        rank = HandRank::FourOfAKind;
+        values.push_back(quads[0]);  // Quad rank
+        // Add best kicker (highest remaining rank, whatever its count)
+        int kicker = 0;
+        if(!singles.empty()) kicker = std::max(kicker, singles[0]);
+        if(!trips.empty()) kicker = std::max(kicker, trips[0]);
+        if(!pairs.empty()) kicker = std::max(kicker, pairs[0]);
+        if(quads.size() > 1) kicker = std::max(kicker, quads[1]);
+        if(kicker > 0) values.push_back(kicker);
     }
     else if(!trips.empty() && !pairs.empty()) {
-        result.rank = HandRank::FullHouse;
-        result.values.push_back(trips[0]);  // Trip rank
-        result.values.push_back(pairs[0]);   // Pair rank
+        rank = HandRank::FullHouse;
+        values.push_back(trips[0]);  // Trip rank
+        values.push_back(pairs[0]);   // Pair rank
     }
     else if(trips.size() >= 2) {
         // Two trips - use highest as trips, second as pair
-        result.rank = HandRank::FullHouse;
-        result.values.push_back(trips[0]);
-        result.values.push_back(trips[1]);
+        rank = HandRank::FullHouse;
+        values.push_back(trips[0]);
+        values.push_back(trips[1]);
     }
     else if(hasFlush) {
-        result.rank = HandRank::Flush;
+        rank = HandRank::Flush;
         // Get the 5 highest cards of the flush suit
         std::vector<int> flushRanks = getFlushCards(allCards, flushSuit);
         for(int i = 0; i < 5 && i < (int)flushRanks.size(); i++) {
-            result.values.push_back(flushRanks[i]);
+            values.push_back(flushRanks[i]);
         }
     }
     else if(hasStraight) {
-        result.rank = HandRank::Straight;
-        result.values.push_back(straightHigh);
+        rank = HandRank::Straight;
+        values.push_back(straightHigh);
     }
     else if(!trips.empty()) {
-        result.rank = HandRank::ThreeOfAKind;
-        result.values.push_back(trips[0]);  // Trip rank
+        rank = HandRank::ThreeOfAKind;
+        values.push_back(trips[0]);  // Trip rank
         // Add top 2 kickers
         int kickersAdded = 0;
         for(int s : singles) {
             if(kickersAdded >= 2) break;
-            result.values.push_back(s);
+            values.push_back(s);
             kickersAdded++;
         }
         for(int p : pairs) {
             if(kickersAdded >= 2) break;
-            result.values.push_back(p);
+            values.push_back(p);
             kickersAdded++;
         }
     }
     else if(pairs.size() >= 2) {
-        result.rank = HandRank::TwoPair;
-        result.values.push_back(pairs[0]);  // Higher pair
-        result.values.push_back(pairs[1]);  // Lower pair
-        // Add best kicker
-        if(!singles.empty()) result.values.push_back(singles[0]);
-        else if(pairs.size() > 2) result.values.push_back(pairs[2]);
+        rank = HandRank::TwoPair;
+        values.push_back(pairs[0]);  // Higher pair
+        values.push_back(pairs[1]);  // Lower pair
+        // Add best kicker (a third pair can outrank the best single)
+        int kicker = 0;
+        if(!singles.empty()) kicker = singles[0];
+        if(pairs.size() > 2) kicker = std::max(kicker, pairs[2]);
+        if(kicker > 0) values.push_back(kicker);
     }
     else if(pairs.size() == 1) {
-        result.rank = HandRank::OnePair;
-        result.values.push_back(pairs[0]);  // Pair rank
+        rank = HandRank::OnePair;
+        values.push_back(pairs[0]);  // Pair rank
         // Add top 3 kickers
         int kickersAdded = 0;
         for(int s : singles) {
             if(kickersAdded >= 3) break;
-            result.values.push_back(s);
+            values.push_back(s);
             kickersAdded++;
         }
     }
     else {
-        result.rank = HandRank::HighCard;
+        rank = HandRank::HighCard;
         // Add top 5 cards
         std::vector<int> allRanksSorted;
         for(const auto& card : allCards) {
@@ -475,38 +377,302 @@ Poker::HandValue Poker::evaluateHandDetailed(const std::vector<Card>& holeCards)
         }
         std::sort(allRanksSorted.rbegin(), allRanksSorted.rend());
         for(int i = 0; i < 5 && i < (int)allRanksSorted.size(); i++) {
-            result.values.push_back(allRanksSorted[i]);
+            values.push_back(allRanksSorted[i]);
         }
     }
     
-    return result;
+    return HandValue::pack(rank, values.data(), static_cast<int>(values.size()));
+}
+
+// Highest rank (2..14) present in a 13-bit rank mask; mask must be non-zero
+static constexpr int highestRank(unsigned rankMask) {
+    return 31 - __builtin_clz(rankMask) + 2;
+}
+
+// Write the top n ranks of a rank mask in descending order, returns how many were written
+static int topRanks(unsigned rankMask, int n, int* out) {
+    int written = 0;
+    while(rankMask && written < n) {
+        int r = highestRank(rankMask);
+        out[written++] = r;
+        rankMask &= ~(1u << (r - 2));
+    }
+    return written;
+}
+
+// High card of the best straight in a 13-bit rank mask (5 for the wheel, 0 if none)
+static constexpr int straightHighFromMask(unsigned rankMask) {
+    // Shift up one bit and copy the Ace into bit 0 so A-2-3-4-5 is an ordinary run
+    unsigned m = (rankMask << 1) | ((rankMask >> 12) & 1u);
+    unsigned runs = m & (m >> 1) & (m >> 2) & (m >> 3) & (m >> 4);
+    if(!runs) {
+        return 0;
+    }
+    // A run starting at bit i covers ranks i+1 .. i+5
+    return 31 - __builtin_clz(runs) + 5;
+}
+
+// Bitmask evaluation: same HandRank and kickers as evaluateHandReference, no allocation
+Poker::HandValue Poker::evaluateMask(CardMask cards) {
+    HandRank rank = HandRank::HighCard;
+    int values[5];
+    int numValues = 0;
+    
+    if(__builtin_popcountll(cards) < 5) {
+        return HandValue::pack(rank, values, numValues);
+    }
+    
+    unsigned s0 = static_cast<unsigned>(cards) & 0x1FFF;
+    unsigned s1 = static_cast<unsigned>(cards >> 16) & 0x1FFF;
+    unsigned s2 = static_cast<unsigned>(cards >> 32) & 0x1FFF;
+    unsigned s3 = static_cast<unsigned>(cards >> 48) & 0x1FFF;
+    
+    // Rank masks by how many suits hold each rank
+    unsigned any = s0 | s1 | s2 | s3;
+    unsigned twoPlus = (s0 & s1) | (s0 & s2) | (s0 & s3) | (s1 & s2) | (s1 & s3) | (s2 & s3);
+    unsigned threePlus = (s0 & s1 & s2) | (s0 & s1 & s3) | (s0 & s2 & s3) | (s1 & s2 & s3);
+    unsigned quads = s0 & s1 & s2 & s3;
+    unsigned trips = threePlus & ~quads;
+    unsigned pairs = twoPlus & ~threePlus;
+    unsigned singles = any & ~twoPlus;
+    
+    // Straight flush
+    unsigned flushSuit = 0;
+    int straightFlushHigh = 0;
+    const unsigned suits[4] = {s0, s1, s2, s3};
+    for(unsigned s : suits) {
+        if(__builtin_popcount(s) >= 5) {
+            if(!flushSuit) flushSuit = s;
+            straightFlushHigh = std::max(straightFlushHigh, straightHighFromMask(s));
+        }
+    }
+    
+    if(straightFlushHigh > 0) {
+        rank = (straightFlushHigh == 14) ? HandRank::RoyalFlush : HandRank::StraightFlush;
+        values[numValues++] = straightFlushHigh;
+    }
+    else if(quads) {
+        rank = HandRank::FourOfAKind;
+        int quadRank = highestRank(quads);
+        values[numValues++] = quadRank;
+        numValues += topRanks(any & ~(1u << (quadRank - 2)), 1, values + numValues);
+    }
+    else if(trips && (pairs || __builtin_popcount(trips) >= 2)) {
+        rank = HandRank::FullHouse;
+        int tripRank = highestRank(trips);
+        values[numValues++] = tripRank;
+        values[numValues++] = highestRank((pairs | trips) & ~(1u << (tripRank - 2)));
+    }
+    else if(flushSuit) {
+        rank = HandRank::Flush;
+        numValues = topRanks(flushSuit, 5, values);
+    }
+    else if(int straightHigh = straightHighFromMask(any)) {
+        rank = HandRank::Straight;
+        values[numValues++] = straightHigh;
+    }
+    else if(trips) {
+        rank = HandRank::ThreeOfAKind;
+        int tripRank = highestRank(trips);
+        values[numValues++] = tripRank;
+        numValues += topRanks(any & ~(1u << (tripRank - 2)), 2, values + numValues);
+    }
+    else if(__builtin_popcount(pairs) >= 2) {
+        rank = HandRank::TwoPair;
+        numValues = topRanks(pairs, 2, values);
+        unsigned rest = any & ~(1u << (values[0] - 2)) & ~(1u << (values[1] - 2));
+        numValues += topRanks(rest, 1, values + numValues);
+    }
+    else if(pairs) {
+        rank = HandRank::OnePair;
+        values[numValues++] = highestRank(pairs);
+        numValues += topRanks(singles, 3, values + numValues);
+    }
+    else {
+        rank = HandRank::HighCard;
+        numValues = topRanks(any, 5, values);
+    }
+
+    return HandValue::pack(rank, values, numValues);
+}
+
+// Detailed hand evaluation with tie-breaking values
+Poker::HandValue Poker::evaluateHandDetailed(const std::vector<Card>& holeCards) const {
+    // Combine hole cards with community cards
+    CardMask allCards = communityCards.cardSet().mask();
+    for(const auto& card : holeCards) {
+        allCards |= cardMask(card);
+    }
+
+    return evaluateMask(allCards);
+}
+
+Poker::HandValue Poker::evaluateHandDetailed(const HoleCards& holeCards) const {
+    return evaluateMask((holeCards.cardSet() | communityCards.cardSet()).mask());
+}
+
+// Lookup tables indexed by a 13-bit rank mask, generated at compile time
+struct StrengthTables {
+    uint16_t colex[8192];     // Colexicographic index of a mask among masks with the same bit count
+    uint8_t bits[8192];       // Number of ranks in a mask
+    uint16_t flush[8192];     // Straight flush / flush strength of a suit mask (0 if fewer than 5 cards)
+    uint16_t unique[8192];    // Straight / high card strength of a distinct-rank mask (0 if fewer than 5)
+};
+
+static constexpr uint16_t strengthOf(HandRank rank, int index) {
+    return static_cast<uint16_t>((static_cast<int>(rank) << 12) | index);
+}
+
+static constexpr StrengthTables buildStrengthTables() {
+    StrengthTables t{};
+
+    // Pascal's triangle for colex ranking, C(n, k) with n <= 13
+    int binom[14][14] = {};
+    for(int n = 0; n < 14; n++) {
+        binom[n][0] = 1;
+        for(int k = 1; k <= n; k++) {
+            binom[n][k] = binom[n-1][k-1] + (k < n ? binom[n-1][k] : 0);
+        }
+    }
+
+    int bitCount[8192] = {};
+    int topBit[8192] = {};
+    for(int m = 1; m < 8192; m++) {
+        bitCount[m] = bitCount[m >> 1] + (m & 1);
+        t.bits[m] = static_cast<uint8_t>(bitCount[m]);
+        topBit[m] = (m >> 1) ? topBit[m >> 1] + 1 : 0;
+        // colex(m) = colex(m without its top bit) + C(topBit, bitCount)
+        t.colex[m] = static_cast<uint16_t>(t.colex[m & ~(1 << topBit[m])] + binom[topBit[m]][bitCount[m]]);
+    }
+
+    for(int m = 1; m < 8192; m++) {
+        if(bitCount[m] < 5) continue;
+
+        // Keep the five highest ranks
+        int top5 = m;
+        while(bitCount[top5] > 5) top5 &= top5 - 1;
+
+        if(int high = straightHighFromMask(m)) {
+            // 0 = wheel ... 9 = broadway
+            t.flush[m] = strengthOf(HandRank::StraightFlush, high - 5);
+            t.unique[m] = strengthOf(HandRank::Straight, high - 5);
+        } else {
+            t.flush[m] = strengthOf(HandRank::Flush, t.colex[top5]);
+            t.unique[m] = strengthOf(HandRank::HighCard, t.colex[top5]);
+        }
+    }
+    return t;
+}
+
+static constexpr StrengthTables kStrengthTables = buildStrengthTables();
+
+// Keep only the n highest bits of a rank mask
+static unsigned keepTop(unsigned rankMask, int n) {
+    while(kStrengthTables.bits[rankMask] > n) rankMask &= rankMask - 1;
+    return rankMask;
+}
+
+// Table-driven evaluation of a 5-7 card mask into a single comparable strength
+HandStrength Poker::evaluateStrength(CardMask cards) {
+    unsigned s0 = static_cast<unsigned>(cards) & 0x1FFF;
+    unsigned s1 = static_cast<unsigned>(cards >> 16) & 0x1FFF;
+    unsigned s2 = static_cast<unsigned>(cards >> 32) & 0x1FFF;
+    unsigned s3 = static_cast<unsigned>(cards >> 48) & 0x1FFF;
+
+    const uint8_t* bits = kStrengthTables.bits;
+    if(bits[s0] + bits[s1] + bits[s2] + bits[s3] < 5) {
+        return 0;
+    }
+
+    // With at most 7 cards a flush rules out quads and full houses
+    if(bits[s0] >= 5) return kStrengthTables.flush[s0];
+    if(bits[s1] >= 5) return kStrengthTables.flush[s1];
+    if(bits[s2] >= 5) return kStrengthTables.flush[s2];
+    if(bits[s3] >= 5) return kStrengthTables.flush[s3];
+
+    unsigned any = s0 | s1 | s2 | s3;
+    unsigned twoPlus = (s0 & s1) | (s0 & s2) | (s0 & s3) | (s1 & s2) | (s1 & s3) | (s2 & s3);
+    if(!twoPlus) {
+        return kStrengthTables.unique[any];
+    }
+
+    unsigned threePlus = (s0 & s1 & s2) | (s0 & s1 & s3) | (s0 & s2 & s3) | (s1 & s2 & s3);
+    unsigned quads = s0 & s1 & s2 & s3;
+    unsigned trips = threePlus & ~quads;
+    unsigned pairs = twoPlus & ~threePlus;
+
+    if(quads) {
+        unsigned quad = keepTop(quads, 1);
+        int kicker = highestRank(any & ~quad) - 2;
+        return strengthOf(HandRank::FourOfAKind, (highestRank(quad) - 2) * 13 + kicker);
+    }
+    if(trips && (pairs || bits[trips] >= 2)) {
+        unsigned trip = keepTop(trips, 1);
+        int pair = highestRank((pairs | trips) & ~trip) - 2;
+        return strengthOf(HandRank::FullHouse, (highestRank(trip) - 2) * 13 + pair);
+    }
+
+    HandStrength straight = kStrengthTables.unique[any];
+    if((straight >> 12) == static_cast<int>(HandRank::Straight)) {
+        return straight;
+    }
+
+    if(trips) {
+        int kickers = kStrengthTables.colex[keepTop(any & ~trips, 2)];
+        return strengthOf(HandRank::ThreeOfAKind, (highestRank(trips) - 2) * 78 + kickers);
+    }
+    if(bits[pairs] >= 2) {
+        unsigned topPairs = keepTop(pairs, 2);
+        int kicker = highestRank(any & ~topPairs) - 2;
+        return strengthOf(HandRank::TwoPair, kStrengthTables.colex[topPairs] * 13 + kicker);
+    }
+    int kickers = kStrengthTables.colex[keepTop(any & ~pairs, 3)];
+    return strengthOf(HandRank::OnePair, (highestRank(pairs) - 2) * 286 + kickers);
+}
+
+// Table-driven evaluation of hole cards + community cards
+HandStrength Poker::evaluateHandStrength(const std::vector<Card>& holeCards) const {
+    CardMask allCards = communityCards.cardSet().mask();
+    for(const auto& card : holeCards) {
+        allCards |= cardMask(card);
+    }
+    return evaluateStrength(allCards);
+}
+
+HandStrength Poker::evaluateHandStrength(const HoleCards& holeCards) const {
+    return evaluateStrength((holeCards.cardSet() | communityCards.cardSet()).mask());
+}
+
+// Recover the hand category from a strength (the best straight flush is a royal flush)
+HandRank Poker::strengthToHandRank(HandStrength strength) {
+    HandRank rank = static_cast<HandRank>(strength >> 12);
+    if(rank == HandRank::StraightFlush && (strength & 0xFFF) == 9) {
+        return HandRank::RoyalFlush;
+    }
+    return rank;
 }
 
 // Determine winners among multiple players (returns winner indices - can be multiple for ties!)
-std::vector<int> Poker::determineWinners(const std::vector<std::vector<Card>>& playerHands) const {
+template <typename Hands>
+static std::vector<int> pickWinners(const Poker& poker, const Hands& playerHands) {
     std::vector<int> winners;
     
     if(playerHands.empty()) {
         return winners;
     }
     
-    // Evaluate all hands
-    std::vector<HandValue> handValues;
-    for(const auto& hand : playerHands) {
-        handValues.push_back(evaluateHandDetailed(hand));
-    }
-    
-    // Find the best hand
-    HandValue bestHand = handValues[0];
+    // Evaluate each hand once, keeping only the best value seen so far
+    Poker::HandValue bestHand = poker.evaluateHandDetailed(playerHands[0]);
     winners.push_back(0);
     
-    for(size_t i = 1; i < handValues.size(); i++) {
-        if(handValues[i] > bestHand) {
+    for(size_t i = 1; i < playerHands.size(); i++) {
+        Poker::HandValue handValue = poker.evaluateHandDetailed(playerHands[i]);
+        if(handValue > bestHand) {
             // New best hand found
-            bestHand = handValues[i];
+            bestHand = handValue;
             winners.clear();
             winners.push_back(i);
-        } else if(handValues[i] == bestHand) {
+        } else if(handValue == bestHand) {
             // Tie - multiple winners!
             winners.push_back(i);
         }
@@ -515,10 +681,18 @@ std::vector<int> Poker::determineWinners(const std::vector<std::vector<Card>>& p
     return winners;
 }
 
+std::vector<int> Poker::determineWinners(const std::vector<std::vector<Card>>& playerHands) const {
+    return pickWinners(*this, playerHands);
+}
+
+std::vector<int> Poker::determineWinners(const std::vector<HoleCards>& playerHands) const {
+    return pickWinners(*this, playerHands);
+}
+
 // Get game state as a string (for debugging/display)
 std::string Poker::getGameState() const {
     std::stringstream ss;
-    ss << "Cards in deck: " << cards.size() << "\n";
+    ss << "Cards in deck: " << (52 - dealt) << "\n";
     ss << "Community cards: " << communityCards.size() << "\n";
     
     if(!communityCards.empty()) {
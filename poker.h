@@ -3,8 +3,12 @@
 
 #include <vector>
 #include <map>
-#include <random>
+#include <memory>
 #include <string>
+#include <array>
+#include <stdexcept>
+#include <cstdint>
+#include "rng.h"
 
 // Enums for card ranks and suits
 enum class Rank {
@@ -38,6 +42,128 @@ struct Card {
     Card(Rank r, Suit s) : rank(r), suit(s) {}
 };
 
+// 64-bit card mask: each suit owns a 16-bit lane whose low 13 bits are a rank mask (bit 0 = Two)
+using CardMask = uint64_t;
+
+// Table-evaluator hand strength: HandRank class in the top 4 bits, ordering within the class
+// in the low 12 bits. Any two 5-7 card hands compare correctly as plain integers.
+using HandStrength = uint16_t;
+
+inline CardMask cardMask(const Card& card) {
+    return 1ULL << (static_cast<int>(card.suit) * 16 + static_cast<int>(card.rank) - 2);
+}
+
+// Compact 1-byte card: index 0..51 = (rank - 2) * 4 + suit
+using CardIndex = uint8_t;
+
+inline CardIndex cardIndex(const Card& card) {
+    return static_cast<CardIndex>((static_cast<int>(card.rank) - 2) * 4 + static_cast<int>(card.suit));
+}
+
+inline Card cardFromIndex(CardIndex index) {
+    return Card(static_cast<Rank>(index / 4 + 2), static_cast<Suit>(index % 4));
+}
+
+inline CardMask cardIndexMask(CardIndex index) {
+    return 1ULL << ((index & 3) * 16 + (index >> 2));
+}
+
+// Set of cards as a 64-bit bitboard (CardMask layout, so it feeds the evaluators directly)
+class CardSet {
+public:
+    // Visits the cards in the set, lowest bit first
+    class const_iterator {
+    public:
+        explicit const_iterator(CardMask rest) : rest(rest) {}
+        CardIndex operator*() const {
+            int bit = __builtin_ctzll(rest);
+            return static_cast<CardIndex>((bit & 15) * 4 + (bit >> 4));
+        }
+        const_iterator& operator++() { rest &= rest - 1; return *this; }
+        bool operator==(const const_iterator& other) const { return rest == other.rest; }
+        bool operator!=(const const_iterator& other) const { return rest != other.rest; }
+    private:
+        CardMask rest;
+    };
+
+    CardSet() : bits(0) {}
+    explicit CardSet(CardMask mask) : bits(mask) {}
+
+    CardMask mask() const { return bits; }
+    bool contains(CardIndex index) const { return (bits & cardIndexMask(index)) != 0; }
+    bool contains(const Card& card) const { return (bits & cardMask(card)) != 0; }
+    bool intersects(CardSet other) const { return (bits & other.bits) != 0; }
+    void add(CardIndex index) { bits |= cardIndexMask(index); }
+    void remove(CardIndex index) { bits &= ~cardIndexMask(index); }
+    int size() const { return __builtin_popcountll(bits); }
+    bool empty() const { return bits == 0; }
+
+    CardSet operator|(CardSet other) const { return CardSet(bits | other.bits); }
+    CardSet& operator|=(CardSet other) { bits |= other.bits; return *this; }
+    CardSet operator&(CardSet other) const { return CardSet(bits & other.bits); }
+
+    const_iterator begin() const { return const_iterator(bits); }
+    const_iterator end() const { return const_iterator(0); }
+
+private:
+    CardMask bits;
+};
+
+// Fixed-capacity inline card storage (no heap). Iterating yields Card values so code that
+// formats cards keeps working; index() and cardSet() expose the compact forms.
+template <size_t N>
+class CardArray {
+public:
+    class const_iterator {
+    public:
+        explicit const_iterator(const CardIndex* pos) : pos(pos) {}
+        Card operator*() const { return cardFromIndex(*pos); }
+        const_iterator& operator++() { ++pos; return *this; }
+        bool operator==(const const_iterator& other) const { return pos == other.pos; }
+        bool operator!=(const const_iterator& other) const { return pos != other.pos; }
+    private:
+        const CardIndex* pos;
+    };
+
+    CardArray() : cards{}, count(0) {}
+
+    void push_back(const Card& card) { push_back(cardIndex(card)); }
+    void push_back(CardIndex index) {
+        if(count >= N) {
+            throw std::runtime_error("Too many cards");
+        }
+        cards[count++] = index;
+        set.add(index);
+    }
+    void clear() { count = 0; set = CardSet(); }
+
+    size_t size() const { return count; }
+    bool empty() const { return count == 0; }
+    Card operator[](size_t i) const { return cardFromIndex(cards[i]); }
+    CardIndex index(size_t i) const { return cards[i]; }
+    CardSet cardSet() const { return set; }
+
+    // Converter for the JSON-facing API
+    std::vector<Card> toCards() const {
+        std::vector<Card> result;
+        for(size_t i = 0; i < count; i++) {
+            result.push_back(cardFromIndex(cards[i]));
+        }
+        return result;
+    }
+
+    const_iterator begin() const { return const_iterator(cards.data()); }
+    const_iterator end() const { return const_iterator(cards.data() + count); }
+
+private:
+    std::array<CardIndex, N> cards;
+    uint8_t count;
+    CardSet set;
+};
+
+using HoleCards = CardArray<2>;
+using Board = CardArray<5>;
+
 // Hand rankings from lowest to highest
 enum class HandRank {
     HighCard = 0,
@@ -58,33 +184,50 @@ public:
     // Hand value structure for detailed comparison
     struct HandValue {
         HandRank rank;
-        std::vector<int> values;  // For tie-breaking (kickers)
+        uint32_t strength;  // rank << 20, then up to five 4-bit kickers, most significant first
+        
+        static HandValue pack(HandRank rank, const int* values, int numValues);
+        int value(int i) const;
         
         bool operator>(const HandValue& other) const;
         bool operator==(const HandValue& other) const;
     };
     
-    // Constructor and destructor
+    // Constructor and destructor. Without an engine the table deals from SecureRng.
     Poker();
+    explicit Poker(std::unique_ptr<DeckRng> rng);
     ~Poker();
     
     // Deck management
     void resetDeck();
     Card drawCard();
+    CardIndex drawCardIndex();
     std::vector<Card> dealCards(int numCards);
+    HoleCards dealHoleCards();
     
     // Community card dealing
     void dealFlop();
     void dealTurn();
     void dealRiver();
     std::vector<Card> getCommunityCards() const;
+    const Board& getBoard() const;
     
     // Hand evaluation
     HandRank evaluateHand(const std::vector<Card>& holeCards) const;
     HandValue evaluateHandDetailed(const std::vector<Card>& holeCards) const;
+    HandValue evaluateHandDetailed(const HoleCards& holeCards) const;
+    HandValue evaluateHandReference(const std::vector<Card>& holeCards) const;
+    static HandValue evaluateMask(CardMask cards);
+    
+    // Table-driven evaluation (tables are generated at compile time)
+    HandStrength evaluateHandStrength(const std::vector<Card>& holeCards) const;
+    HandStrength evaluateHandStrength(const HoleCards& holeCards) const;
+    static HandStrength evaluateStrength(CardMask cards);
+    static HandRank strengthToHandRank(HandStrength strength);
     
     // Winner determination
     std::vector<int> determineWinners(const std::vector<std::vector<Card>>& playerHands) const;
+    std::vector<int> determineWinners(const std::vector<HoleCards>& playerHands) const;
     
     // Utility functions
     std::string getGameState() const;
@@ -93,16 +236,14 @@ public:
     std::string handRankToString(HandRank hr) const;
     
 private:
-    std::vector<Card> cards;              // Deck of remaining cards
-    std::vector<Card> communityCards;     // Community cards (flop, turn, river)
-    std::random_device rd;
-    std::mt19937 gen;                     // Random number generator for shuffling
+    std::array<CardIndex, 52> deck;       // deck[0..dealt) are dealt, the rest are still undrawn
+    int dealt;
+    Board communityCards;                 // Community cards (flop, turn, river)
+    std::unique_ptr<DeckRng> rng;         // Shuffle randomness, chosen per table
     
     // Helper functions for hand evaluation
     std::map<Rank, int> countRanks(const std::vector<Card>& hand) const;
     std::map<Suit, int> countSuits(const std::vector<Card>& hand) const;
-    bool isFlush(const std::vector<Card>& hand) const;
-    bool isStraight(const std::vector<Card>& hand) const;
 };
 
 #endif // POKER_H
\ No newline at end of file
@@ -0,0 +1,136 @@
+#include "preflop.h"
+#include <cstring>
+#include <iostream>
+#include <algorithm>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+PreflopTable::PreflopTable()
+    : mapped(nullptr), mappedSize(0), classMatrix(nullptr), comboMatrix(nullptr) {
+}
+
+PreflopTable::~PreflopTable() {
+    if(mapped) {
+        munmap(mapped, mappedSize);
+    }
+}
+
+bool PreflopTable::load(const std::string& path) {
+    int fd = open(path.c_str(), O_RDONLY);
+    if(fd < 0) {
+        return false;
+    }
+
+    struct stat st;
+    if(fstat(fd, &st) < 0 || static_cast<size_t>(st.st_size) < sizeof(PreflopFileHeader)) {
+        close(fd);
+        std::cerr << "Preflop table " << path << " is truncated" << std::endl;
+        return false;
+    }
+
+    size_t size = static_cast<size_t>(st.st_size);
+    void* data = mmap(nullptr, size, PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+    if(data == MAP_FAILED) {
+        std::cerr << "Failed to mmap preflop table " << path << std::endl;
+        return false;
+    }
+
+    const PreflopFileHeader* header = static_cast<const PreflopFileHeader*>(data);
+    const uint64_t classBytes = sizeof(uint16_t) * NUM_CLASSES * NUM_CLASSES;
+    const uint64_t comboBytes = sizeof(uint16_t) * NUM_COMBOS * NUM_COMBOS;
+    bool valid = std::memcmp(header->magic, PREFLOP_MAGIC, sizeof(PREFLOP_MAGIC)) == 0
+        && header->version == PREFLOP_FILE_VERSION
+        && header->numClasses == NUM_CLASSES
+        && header->numCombos == NUM_COMBOS
+        && header->classOffset % alignof(uint16_t) == 0
+        && header->comboOffset % alignof(uint16_t) == 0
+        && header->classOffset + classBytes <= size
+        && header->comboOffset + comboBytes <= size;
+    if(!valid) {
+        munmap(data, size);
+        std::cerr << "Preflop table " << path << " has an unsupported format" << std::endl;
+        return false;
+    }
+
+    if(mapped) {
+        munmap(mapped, mappedSize);
+    }
+    mapped = data;
+    mappedSize = size;
+    classMatrix = reinterpret_cast<const uint16_t*>(static_cast<const char*>(data) + header->classOffset);
+    comboMatrix = reinterpret_cast<const uint16_t*>(static_cast<const char*>(data) + header->comboOffset);
+    return true;
+}
+
+double PreflopTable::classEquity(int heroClass, int villainClass) const {
+    if(!mapped || heroClass < 0 || heroClass >= NUM_CLASSES || villainClass < 0 || villainClass >= NUM_CLASSES) {
+        return -1.0;
+    }
+    return decodeEquity(classMatrix[heroClass * NUM_CLASSES + villainClass]);
+}
+
+double PreflopTable::comboEquity(int heroCombo, int villainCombo) const {
+    if(!mapped || heroCombo < 0 || heroCombo >= NUM_COMBOS || villainCombo < 0 || villainCombo >= NUM_COMBOS) {
+        return -1.0;
+    }
+    return decodeEquity(comboMatrix[heroCombo * NUM_COMBOS + villainCombo]);
+}
+
+double PreflopTable::equity(const HoleCards& hero, const HoleCards& villain) const {
+    if(hero.size() != 2 || villain.size() != 2) {
+        return -1.0;
+    }
+    return comboEquity(comboIndex(hero[0], hero[1]), comboIndex(villain[0], villain[1]));
+}
+
+int PreflopTable::comboIndex(const Card& a, const Card& b) {
+    int lo = cardIndex(a);
+    int hi = cardIndex(b);
+    if(lo > hi) {
+        std::swap(lo, hi);
+    }
+    return hi * (hi - 1) / 2 + lo;
+}
+
+void PreflopTable::comboCards(int combo, Card& a, Card& b) {
+    int hi = 1;
+    while((hi + 1) * hi / 2 <= combo) {
+        hi++;
+    }
+    a = cardFromIndex(static_cast<CardIndex>(combo - hi * (hi - 1) / 2));
+    b = cardFromIndex(static_cast<CardIndex>(hi));
+}
+
+int PreflopTable::handClass(const Card& a, const Card& b) {
+    // Grid rows/columns run Ace (0) down to Two (12)
+    int hi = 14 - std::max(static_cast<int>(a.rank), static_cast<int>(b.rank));
+    int lo = 14 - std::min(static_cast<int>(a.rank), static_cast<int>(b.rank));
+    if(hi == lo) {
+        return hi * 13 + hi;
+    }
+    return (a.suit == b.suit) ? hi * 13 + lo : lo * 13 + hi;
+}
+
+std::string PreflopTable::className(int handClass) {
+    static const char* ranks = "AKQJT98765432";
+    int row = handClass / 13;
+    int col = handClass % 13;
+    if(row == col) {
+        return std::string{ranks[row], ranks[col]};
+    }
+    if(row < col) {
+        return std::string{ranks[row], ranks[col], 's'};
+    }
+    return std::string{ranks[col], ranks[row], 'o'};
+}
+
+uint16_t PreflopTable::encodeEquity(double equity) {
+    return static_cast<uint16_t>(std::clamp(equity, 0.0, 1.0) * PREFLOP_EQUITY_SCALE + 0.5);
+}
+
+double PreflopTable::decodeEquity(uint16_t value) {
+    return value == PREFLOP_BLOCKED ? -1.0 : value / PREFLOP_EQUITY_SCALE;
+}
@@ -0,0 +1,68 @@
+#ifndef PREFLOP_H
+#define PREFLOP_H
+
+#include <string>
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+#include "poker.h"
+
+// On-disk layout of the preflop equity file written by preflop_gen (native little-endian).
+// Both matrices hold the row hand's heads-up equity against the column hand, scaled to
+// 0..PREFLOP_EQUITY_SCALE; PREFLOP_BLOCKED marks combo pairs that share a card.
+const char PREFLOP_MAGIC[8] = {'P', 'K', 'R', 'P', 'F', 'E', 'Q', '\0'};
+const uint32_t PREFLOP_FILE_VERSION = 1;
+const uint32_t PREFLOP_FLAG_EXACT = 1;  // Built by full enumeration rather than sampling
+const uint16_t PREFLOP_BLOCKED = 0xFFFF;
+const double PREFLOP_EQUITY_SCALE = 65534.0;
+
+struct PreflopFileHeader {
+    char magic[8];
+    uint32_t version;
+    uint32_t numClasses;    // 169
+    uint32_t numCombos;     // 1326
+    uint32_t flags;
+    uint64_t samples;       // Runouts per matchup when sampled, 0 when exact
+    uint64_t classOffset;   // Byte offset of the numClasses x numClasses uint16 matrix
+    uint64_t comboOffset;   // Byte offset of the numCombos x numCombos uint16 matrix
+};
+
+// Memory-mapped 169x169 class and 1326x1326 combo preflop equity tables
+class PreflopTable {
+public:
+    static const int NUM_CLASSES = 169;
+    static const int NUM_COMBOS = 1326;
+
+    PreflopTable();
+    ~PreflopTable();
+    PreflopTable(const PreflopTable&) = delete;
+    PreflopTable& operator=(const PreflopTable&) = delete;
+
+    // Map and validate a table file; returns false (leaving the table unloaded) on any error
+    bool load(const std::string& path);
+    bool isLoaded() const { return mapped != nullptr; }
+
+    // Heads-up equity of the first hand, or -1 if unavailable (not loaded / cards overlap)
+    double classEquity(int heroClass, int villainClass) const;
+    double comboEquity(int heroCombo, int villainCombo) const;
+    double equity(const HoleCards& hero, const HoleCards& villain) const;
+
+    // Combo 0..1325 indexes an unordered pair of cards (by CardIndex)
+    static int comboIndex(const Card& a, const Card& b);
+    static void comboCards(int combo, Card& a, Card& b);
+
+    // Class 0..168 on the usual 13x13 grid: pairs on the diagonal, suited above, offsuit below
+    static int handClass(const Card& a, const Card& b);
+    static std::string className(int handClass);
+
+    static uint16_t encodeEquity(double equity);
+    static double decodeEquity(uint16_t value);
+
+private:
+    void* mapped;
+    size_t mappedSize;
+    const uint16_t* classMatrix;
+    const uint16_t* comboMatrix;
+};
+
+#endif // PREFLOP_H
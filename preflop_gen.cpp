@@ -0,0 +1,168 @@
+// Generates the preflop heads-up equity file loaded by the server (see preflop.h).
+//
+//   ./preflop_gen [-o preflop_equity.bin] [--threads N] [--trials N]
+//
+// By default every combo-vs-combo matchup is enumerated exactly. Matchups that are identical up
+// to a suit permutation are computed once. --trials N samples N runouts per matchup instead,
+// which is much faster and is handy for development builds.
+
+#include "preflop.h"
+#include "equity.h"
+#include <iostream>
+#include <fstream>
+#include <algorithm>
+#include <unordered_map>
+#include <chrono>
+#include <cstring>
+
+// Canonical key of a matchup under the 24 suit permutations (lowest hero*1326+villain wins)
+static uint32_t canonicalMatchup(int hero, int villain, const std::vector<std::vector<int>>& perms) {
+    Card h1(Rank::Two, Suit::Hearts), h2 = h1, v1 = h1, v2 = h1;
+    PreflopTable::comboCards(hero, h1, h2);
+    PreflopTable::comboCards(villain, v1, v2);
+
+    uint32_t best = UINT32_MAX;
+    for(const auto& perm : perms) {
+        auto remap = [&perm](const Card& c) {
+            return Card(c.rank, static_cast<Suit>(perm[static_cast<int>(c.suit)]));
+        };
+        uint32_t key = PreflopTable::comboIndex(remap(h1), remap(h2)) * PreflopTable::NUM_COMBOS
+                     + PreflopTable::comboIndex(remap(v1), remap(v2));
+        best = std::min(best, key);
+    }
+    return best;
+}
+
+int main(int argc, char* argv[]) {
+    std::string outPath = "preflop_equity.bin";
+    int threads = 0;
+    uint64_t trials = 0;
+
+    for(int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        if((arg == "-o" || arg == "--output") && i + 1 < argc) {
+            outPath = argv[++i];
+        } else if(arg == "--threads" && i + 1 < argc) {
+            threads = std::stoi(argv[++i]);
+        } else if(arg == "--trials" && i + 1 < argc) {
+            trials = std::stoull(argv[++i]);
+        } else {
+            std::cerr << "Usage: " << argv[0] << " [-o FILE] [--threads N] [--trials N]" << std::endl;
+            return 1;
+        }
+    }
+
+    const int N = PreflopTable::NUM_COMBOS;
+    EquityCalculator calculator(threads);
+
+    std::vector<std::vector<int>> perms;
+    std::vector<int> perm = {0, 1, 2, 3};
+    do {
+        perms.push_back(perm);
+    } while(std::next_permutation(perm.begin(), perm.end()));
+
+    // Group the hero < villain matchups by suit-isomorphism class
+    std::vector<uint16_t> combo(static_cast<size_t>(N) * N, PREFLOP_BLOCKED);
+    std::unordered_map<uint32_t, double> canonicalEquity;
+    std::vector<uint32_t> pending;
+    for(int hero = 0; hero < N; hero++) {
+        Card h1(Rank::Two, Suit::Hearts), h2 = h1;
+        PreflopTable::comboCards(hero, h1, h2);
+        for(int villain = hero + 1; villain < N; villain++) {
+            Card v1(Rank::Two, Suit::Hearts), v2 = v1;
+            PreflopTable::comboCards(villain, v1, v2);
+            CardMask heroMask = cardMask(h1) | cardMask(h2);
+            if(heroMask & (cardMask(v1) | cardMask(v2))) {
+                continue;
+            }
+            uint32_t key = canonicalMatchup(hero, villain, perms);
+            if(canonicalEquity.emplace(key, 0.0).second) {
+                pending.push_back(key);
+            }
+        }
+    }
+
+    std::cerr << "Computing " << pending.size() << " distinct matchups ("
+              << (trials ? std::to_string(trials) + " runouts each" : std::string("exact")) << ", "
+              << calculator.getNumThreads() << " threads)" << std::endl;
+
+    auto started = std::chrono::steady_clock::now();
+    for(size_t i = 0; i < pending.size(); i++) {
+        Card h1(Rank::Two, Suit::Hearts), h2 = h1, v1 = h1, v2 = h1;
+        PreflopTable::comboCards(pending[i] / N, h1, h2);
+        PreflopTable::comboCards(pending[i] % N, v1, v2);
+        std::vector<std::vector<Card>> hands = {{h1, h2}, {v1, v2}};
+
+        EquityResult result = trials ? calculator.monteCarlo(hands, {}, {}, trials, i)
+                                     : calculator.exact(hands, {}, {});
+        canonicalEquity[pending[i]] = result.equity[0];
+
+        if((i + 1) % 1000 == 0 || i + 1 == pending.size()) {
+            double elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - started).count();
+            std::cerr << "  " << (i + 1) << "/" << pending.size() << " matchups, " << elapsed << "s" << std::endl;
+        }
+    }
+
+    // Expand back to the full combo matrix; the reversed matchup gets the complementary equity
+    for(int hero = 0; hero < N; hero++) {
+        for(int villain = hero + 1; villain < N; villain++) {
+            auto it = canonicalEquity.find(canonicalMatchup(hero, villain, perms));
+            if(it == canonicalEquity.end()) {
+                continue;  // Shares a card
+            }
+            combo[static_cast<size_t>(hero) * N + villain] = PreflopTable::encodeEquity(it->second);
+            combo[static_cast<size_t>(villain) * N + hero] = PreflopTable::encodeEquity(1.0 - it->second);
+        }
+    }
+
+    // Class equity is the average over every card-disjoint combo pairing of the two classes
+    const int C = PreflopTable::NUM_CLASSES;
+    std::vector<double> classSum(static_cast<size_t>(C) * C, 0.0);
+    std::vector<int> classCount(static_cast<size_t>(C) * C, 0);
+    std::vector<int> comboClass(N);
+    for(int c = 0; c < N; c++) {
+        Card a(Rank::Two, Suit::Hearts), b = a;
+        PreflopTable::comboCards(c, a, b);
+        comboClass[c] = PreflopTable::handClass(a, b);
+    }
+    for(int hero = 0; hero < N; hero++) {
+        for(int villain = 0; villain < N; villain++) {
+            uint16_t value = combo[static_cast<size_t>(hero) * N + villain];
+            if(value == PREFLOP_BLOCKED) {
+                continue;
+            }
+            size_t cell = static_cast<size_t>(comboClass[hero]) * C + comboClass[villain];
+            classSum[cell] += PreflopTable::decodeEquity(value);
+            classCount[cell]++;
+        }
+    }
+    std::vector<uint16_t> classes(static_cast<size_t>(C) * C, PREFLOP_BLOCKED);
+    for(size_t cell = 0; cell < classes.size(); cell++) {
+        if(classCount[cell] > 0) {
+            classes[cell] = PreflopTable::encodeEquity(classSum[cell] / classCount[cell]);
+        }
+    }
+
+    PreflopFileHeader header;
+    std::memset(&header, 0, sizeof(header));
+    std::memcpy(header.magic, PREFLOP_MAGIC, sizeof(PREFLOP_MAGIC));
+    header.version = PREFLOP_FILE_VERSION;
+    header.numClasses = C;
+    header.numCombos = N;
+    header.flags = trials ? 0 : PREFLOP_FLAG_EXACT;
+    header.samples = trials;
+    header.classOffset = sizeof(PreflopFileHeader);
+    header.comboOffset = header.classOffset + classes.size() * sizeof(uint16_t);
+
+    std::ofstream out(outPath, std::ios::binary | std::ios::trunc);
+    out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    out.write(reinterpret_cast<const char*>(classes.data()), classes.size() * sizeof(uint16_t));
+    out.write(reinterpret_cast<const char*>(combo.data()), combo.size() * sizeof(uint16_t));
+    if(!out) {
+        std::cerr << "Failed to write " << outPath << std::endl;
+        return 1;
+    }
+
+    std::cerr << "Wrote " << outPath << std::endl;
+    return 0;
+}
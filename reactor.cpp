@@ -0,0 +1,410 @@
+#include "reactor.h"
+#include "uring.h"
+#include "log.h"
+#include <algorithm>
+#include <stdexcept>
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/socket.h>
+#include <sys/resource.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+
+static const int MAX_EVENTS = 256;
+static const size_t READ_CHUNK = 4096;     // Least free space offered to each recv (the buffer grows)
+
+// Low-latency mode: while this thread runs a handler, connections it sends to are collected here
+// instead of being written to one message at a time, and flushed when the handler returns
+static thread_local bool deferringFlush = false;
+static thread_local std::vector<std::shared_ptr<Connection>> deferredFlush;
+
+static bool setNonBlocking(int fd) {
+    int flags = fcntl(fd, F_GETFL, 0);
+    return flags >= 0 && fcntl(fd, F_SETFL, flags | O_NONBLOCK) == 0;
+}
+
+Reactor::Reactor(ConnectionHandler& handler, const ServerConfig& config)
+    : handler(handler), numThreads(config.ioThreads),
+      limits{config.maxQueuedBytes, config.maxQueuedMessages},
+      slowConsumerTimeout(config.slowConsumerMs), handshakeTimeout(config.handshakeTimeoutMs),
+      lowLatency(config.lowLatency), running(false) {
+    if (this->numThreads <= 0) {
+        this->numThreads = static_cast<int>(std::min(4u, std::max(1u, std::thread::hardware_concurrency())));
+    }
+
+    // Every connection costs an fd, so lift the soft limit as far as we are allowed
+    struct rlimit limit;
+    if (getrlimit(RLIMIT_NOFILE, &limit) == 0 && limit.rlim_cur < limit.rlim_max) {
+        limit.rlim_cur = limit.rlim_max;
+        setrlimit(RLIMIT_NOFILE, &limit);
+    }
+}
+
+std::shared_ptr<Connection> Reactor::find(int fd) {
+    std::shared_lock<std::shared_mutex> lock(registryLock);
+    auto it = connections.find(fd);
+    return it == connections.end() ? nullptr : it->second;
+}
+
+void Reactor::registerConnection(const std::shared_ptr<Connection>& conn) {
+    std::unique_lock<std::shared_mutex> lock(registryLock);
+    connections[conn->fd] = conn;
+}
+
+std::shared_ptr<Connection> Reactor::unregisterConnection(int fd) {
+    std::unique_lock<std::shared_mutex> lock(registryLock);
+    auto it = connections.find(fd);
+    if (it == connections.end()) {
+        return nullptr;
+    }
+    std::shared_ptr<Connection> conn = it->second;
+    connections.erase(it);
+    return conn;
+}
+
+void Reactor::tuneSocket(int fd) {
+    if (lowLatency) {
+        int on = 1;
+        setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &on, sizeof(on));
+    }
+}
+
+bool Reactor::enqueue(Connection& conn, OutboundMessage message) {
+    if (!conn.backlogged()) {
+        conn.backlogSince = std::chrono::steady_clock::now();
+    }
+    if (conn.output.push(std::move(message), limits) == OutboundQueue::Push::OVERFLOW) {
+        LOG_WARN(NET, "Disconnecting slow consumer fd=" << conn.fd << ": outbound queue full ("
+                      << conn.output.size() << " messages, " << conn.pendingBytes() << " bytes)");
+        requestClose(conn);
+        return false;
+    }
+    return true;
+}
+
+void Reactor::requestClose(Connection& conn) {
+    if (!conn.closed && !conn.closing.exchange(true)) {
+        shutdown(conn.fd, SHUT_RD);
+    }
+}
+
+void Reactor::evictStalled(int loop) {
+    if (slowConsumerTimeout.count() <= 0 && handshakeTimeout.count() <= 0) {
+        return;
+    }
+    std::vector<std::shared_ptr<Connection>> owned;
+    {
+        std::shared_lock<std::shared_mutex> lock(registryLock);
+        for (const auto& entry : connections) {
+            if (entry.second->loop == loop) {
+                owned.push_back(entry.second);
+            }
+        }
+    }
+
+    auto now = std::chrono::steady_clock::now();
+    for (const auto& conn : owned) {
+        std::lock_guard<std::mutex> lock(conn->outputLock);
+        if (conn->closing) {
+            continue;
+        }
+        if (conn->upgrading && handshakeTimeout.count() > 0 && now - conn->openedAt > handshakeTimeout) {
+            LOG_WARN(NET, "Disconnecting fd=" << conn->fd << ": no WebSocket handshake within "
+                          << handshakeTimeout.count() << "ms (" << conn->input.size() << " bytes received)");
+            requestClose(*conn);
+        } else if (conn->backlogged() && slowConsumerTimeout.count() > 0 &&
+                   now - conn->backlogSince > slowConsumerTimeout) {
+            LOG_WARN(NET, "Disconnecting slow consumer fd=" << conn->fd << ": output stalled for over "
+                          << slowConsumerTimeout.count() << "ms (" << conn->pendingBytes() << " bytes pending)");
+            requestClose(*conn);
+        }
+    }
+}
+
+std::unique_ptr<Reactor> makeReactor(ConnectionHandler& handler, const ServerConfig& config) {
+    if (config.io == IoBackend::URING) {
+        try {
+            return std::make_unique<UringReactor>(handler, config);
+        } catch (const std::exception& e) {
+            LOG_WARN(SERVER, "io_uring unavailable (" << e.what() << "), falling back to epoll");
+        }
+    }
+    return std::make_unique<EpollReactor>(handler, config);
+}
+
+EpollReactor::EpollReactor(ConnectionHandler& handler, const ServerConfig& config)
+    : Reactor(handler, config), nextLoop(0) {
+    for (int i = 0; i < this->numThreads; i++) {
+        Loop loop;
+        loop.epollFd = epoll_create1(EPOLL_CLOEXEC);
+        loop.wakeFd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+        if (loop.epollFd < 0 || loop.wakeFd < 0) {
+            throw std::runtime_error("Failed to create epoll instance");
+        }
+        epoll_event ev{};
+        ev.events = EPOLLIN;
+        ev.data.ptr = nullptr;   // nullptr marks the wake-up eventfd
+        epoll_ctl(loop.epollFd, EPOLL_CTL_ADD, loop.wakeFd, &ev);
+        loops.push_back(loop);
+    }
+}
+
+EpollReactor::~EpollReactor() {
+    stop();
+    for (auto& thread : threads) {
+        if (thread.joinable()) {
+            thread.join();
+        }
+    }
+    for (const auto& loop : loops) {
+        ::close(loop.epollFd);
+        ::close(loop.wakeFd);
+    }
+}
+
+void EpollReactor::listen(int fd, ClientType type) {
+    setNonBlocking(fd);
+    auto listener = std::make_shared<Connection>(fd, type, true, -1);
+    for (const auto& loop : loops) {
+        epoll_event ev{};
+        ev.events = EPOLLIN | EPOLLEXCLUSIVE;
+        ev.data.ptr = listener.get();
+        if (epoll_ctl(loop.epollFd, EPOLL_CTL_ADD, fd, &ev) < 0) {
+            throw std::runtime_error("Failed to register listening socket");
+        }
+    }
+    listeners.push_back(listener);
+}
+
+void EpollReactor::adopt(int fd, ClientType type) {
+    setNonBlocking(fd);
+    tuneSocket(fd);
+    int index = static_cast<int>(nextLoop++ % loops.size());
+    auto conn = std::make_shared<Connection>(fd, type, false, index);
+    registerConnection(conn);
+    handler.onOpen(*conn);
+
+    epoll_event ev{};
+    ev.events = EPOLLIN | EPOLLOUT | EPOLLRDHUP | EPOLLET;
+    ev.data.ptr = conn.get();
+    if (epoll_ctl(loops[index].epollFd, EPOLL_CTL_ADD, fd, &ev) < 0) {
+        LOG_ERROR(NET, "Failed to register fd=" << fd << ": " << strerror(errno));
+        unregisterConnection(fd);
+        ::close(fd);
+    }
+}
+
+bool EpollReactor::send(int fd, OutboundMessage message) {
+    std::shared_ptr<Connection> conn = find(fd);
+    if (!conn) {
+        return false;
+    }
+
+    std::lock_guard<std::mutex> lock(conn->outputLock);
+    if (conn->closed || conn->closing) {
+        return false;
+    }
+    bool idle = conn->output.empty();
+    if (!enqueue(*conn, std::move(message))) {
+        return false;
+    }
+    // With nothing pending try to write now; otherwise EPOLLOUT will pick it up. Under a
+    // low-latency handler the write waits for the handler to return, or for a full batch.
+    if (deferringFlush && (idle || conn->flushQueued)) {
+        if (!conn->flushQueued) {
+            conn->flushQueued = true;
+            deferredFlush.push_back(conn);
+        }
+        if (conn->output.size() == MAX_GATHER_SEGMENTS / 2 && !flush(*conn)) {
+            requestClose(*conn);
+        }
+    } else if (idle && !flush(*conn)) {
+        requestClose(*conn);
+    }
+    return true;
+}
+
+void EpollReactor::close(int fd) {
+    std::shared_ptr<Connection> conn = find(fd);
+    if (conn) {
+        std::lock_guard<std::mutex> lock(conn->outputLock);
+        requestClose(*conn);
+    }
+}
+
+bool EpollReactor::flush(Connection& conn) {
+    while (!conn.output.empty()) {
+        // Heads and (possibly shared) bodies of everything queued go out in one call
+        iovec segments[MAX_GATHER_SEGMENTS];
+        msghdr msg{};
+        msg.msg_iov = segments;
+        msg.msg_iovlen = conn.output.gather(segments, MAX_GATHER_SEGMENTS);
+        ssize_t sent = sendmsg(conn.fd, &msg, MSG_NOSIGNAL);
+        if (sent > 0) {
+            conn.output.consume(sent);
+            conn.backlogSince = std::chrono::steady_clock::now();
+        } else if (sent < 0 && errno == EINTR) {
+            continue;
+        } else if (sent < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+            return true;
+        } else {
+            return false;
+        }
+    }
+    return true;
+}
+
+void EpollReactor::acceptAll(Connection& listener) {
+    while (true) {
+        int fd = accept4(listener.fd, nullptr, nullptr, SOCK_NONBLOCK | SOCK_CLOEXEC);
+        if (fd < 0) {
+            if (errno == EINTR || errno == ECONNABORTED) {
+                continue;
+            }
+            if (errno != EAGAIN && errno != EWOULDBLOCK) {
+                LOG_ERROR(NET, "Accept failed: " << strerror(errno));
+            }
+            return;
+        }
+        adopt(fd, listener.type);
+    }
+}
+
+// Edge-triggered, so read until the socket is drained. Input is read at most the handler's
+// limit ahead and handed over whenever it fills up. Returns false once the peer is gone.
+bool EpollReactor::readAll(Connection& conn) {
+    while (true) {
+        size_t limit = handler.inputLimit(conn);
+        bool open = true;
+        bool drained = false;
+        while (conn.input.size() < limit) {
+            // Straight into the connection's input buffer, with no staging copy
+            char* space = conn.input.reserve(READ_CHUNK);
+            size_t wanted = std::min(conn.input.room(), limit - conn.input.size());
+            ssize_t received = recv(conn.fd, space, wanted, 0);
+            if (received > 0) {
+                conn.input.commit(received);
+                continue;
+            }
+            if (received < 0 && errno == EINTR) {
+                continue;
+            }
+            if (received == 0 || (errno != EAGAIN && errno != EWOULDBLOCK)) {
+                open = false;
+            }
+            drained = true;
+            break;
+        }
+
+        // Bytes that arrived just before a close are still delivered
+        if (!conn.input.empty() && !conn.closing) {
+            deferringFlush = lowLatency;
+            handler.onData(conn);
+            deferringFlush = false;
+            flushDeferred();
+        }
+        if (drained || conn.closing) {
+            return open;
+        }
+        if (conn.input.size() >= handler.inputLimit(conn)) {
+            LOG_WARN(NET, "Disconnecting fd=" << conn.fd << ": " << conn.input.size()
+                          << " bytes received without a complete message");
+            return false;
+        }
+    }
+}
+
+// Flush point after a handler: each connection it sent to is written with one gathered sendmsg
+void EpollReactor::flushDeferred() {
+    for (const auto& conn : deferredFlush) {
+        std::lock_guard<std::mutex> lock(conn->outputLock);
+        conn->flushQueued = false;
+        if (!conn->closed && !flush(*conn)) {
+            requestClose(*conn);
+        }
+    }
+    deferredFlush.clear();
+}
+
+void EpollReactor::destroy(Connection& conn) {
+    std::shared_ptr<Connection> keep = unregisterConnection(conn.fd);
+    epoll_ctl(loops[conn.loop].epollFd, EPOLL_CTL_DEL, conn.fd, nullptr);
+    handler.onClose(conn);
+
+    std::lock_guard<std::mutex> lock(conn.outputLock);
+    flush(conn);   // Best effort for anything queued before the close (e.g. an error reply)
+    ::close(conn.fd);
+    conn.closed = true;
+}
+
+void EpollReactor::loop(int index) {
+    epoll_event events[MAX_EVENTS];
+    auto nextSweep = std::chrono::steady_clock::now() + std::chrono::milliseconds(SWEEP_INTERVAL_MS);
+    while (running) {
+        int count = epoll_wait(loops[index].epollFd, events, MAX_EVENTS, SWEEP_INTERVAL_MS);
+        if (count < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            LOG_ERROR(NET, "epoll_wait failed: " << strerror(errno));
+            break;
+        }
+
+        for (int i = 0; i < count; i++) {
+            Connection* conn = static_cast<Connection*>(events[i].data.ptr);
+            if (!conn) {
+                uint64_t value;
+                while (read(loops[index].wakeFd, &value, sizeof(value)) > 0) {}
+                continue;
+            }
+            if (conn->listening) {
+                acceptAll(*conn);
+                continue;
+            }
+
+            uint32_t flags = events[i].events;
+            bool open = true;
+            if (flags & EPOLLOUT) {
+                std::lock_guard<std::mutex> lock(conn->outputLock);
+                open = flush(*conn);
+            }
+            if (open && (flags & (EPOLLIN | EPOLLRDHUP | EPOLLHUP | EPOLLERR))) {
+                open = readAll(*conn);
+            }
+            if (!open || conn->closing) {
+                destroy(*conn);
+            }
+        }
+
+        auto now = std::chrono::steady_clock::now();
+        if (now >= nextSweep) {
+            evictStalled(index);
+            nextSweep = now + std::chrono::milliseconds(SWEEP_INTERVAL_MS);
+        }
+    }
+}
+
+void EpollReactor::run() {
+    running = true;
+    for (int i = 1; i < getNumThreads(); i++) {
+        threads.emplace_back(&EpollReactor::loop, this, i);
+    }
+    loop(0);
+    for (auto& thread : threads) {
+        thread.join();
+    }
+    threads.clear();
+}
+
+void EpollReactor::stop() {
+    running = false;
+    for (const auto& loop : loops) {
+        uint64_t one = 1;
+        ssize_t ignored = write(loop.wakeFd, &one, sizeof(one));
+        (void)ignored;
+    }
+}
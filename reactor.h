@@ -0,0 +1,196 @@
+#ifndef REACTOR_H
+#define REACTOR_H
+
+#include <string>
+#include <vector>
+#include <memory>
+#include <mutex>
+#include <shared_mutex>
+#include <thread>
+#include <atomic>
+#include <unordered_map>
+#include <chrono>
+#include <sys/socket.h>
+#include "config.h"
+#include "inbound.h"
+#include "outbound.h"
+
+class DeflateSession;
+
+enum class ClientType {
+    TCP,
+    WEBSOCKET
+};
+
+// Message encoding negotiated per connection; JSON unless the client asks for a binary one
+enum class WireEncoding {
+    JSON,
+    MSGPACK,
+    CBOR,
+    COMPACT     // Raw TCP only: compact.h schema messages, with JSON for everything else
+};
+
+// One socket owned by a reactor thread. input is only touched by the owning thread; output is
+// shared with every thread that sends to the connection and is guarded by outputLock.
+struct Connection {
+    int fd;
+    ClientType type;
+    bool listening;                 // Listening socket rather than a client
+    int loop;                       // Index of the reactor thread that owns the fd
+    InputBuffer input;              // Received bytes not yet consumed by the handler
+    std::mutex outputLock;
+    OutboundQueue output;           // Messages not yet handed to the kernel
+    // When output started queueing, or last drained any of it; eviction counts from here
+    std::chrono::steady_clock::time_point backlogSince;
+    bool closed;                    // fd has been closed (guarded by outputLock)
+    std::atomic<bool> closing;
+    std::string username;           // Session state kept by the server
+    WireEncoding encoding = WireEncoding::JSON;
+    bool encodingChosen = false;    // Raw TCP: the optional flag byte has been looked for
+    // WebSocket: the HTTP upgrade request has not been answered yet. The handler clears it; the
+    // reactor closes connections still upgrading handshakeTimeout after openedAt.
+    bool upgrading;
+    std::chrono::steady_clock::time_point openedAt;
+    size_t scanned = 0;             // How much of input the handler has already searched
+    // WebSocket message arriving in fragments, at positions from the start of the unconsumed
+    // input: the unmasked payload so far is [fragmentStart, fragmentStart + fragmentLength) and
+    // the next frame starts at fragmentEnd
+    int fragmentOpcode = 0;         // Opcode of the first fragment; 0 while no message is open
+    size_t fragmentStart = 0;
+    size_t fragmentLength = 0;
+    size_t fragmentEnd = 0;
+    bool fragmentCompressed = false;    // The open message has RSV1 set (permessage-deflate)
+    std::shared_ptr<DeflateSession> deflate;    // Set if the client negotiated permessage-deflate
+
+    bool flushQueued = false;       // Waiting in a flush list (guarded by outputLock)
+
+    // Owned by the loop thread of asynchronous backends (io_uring)
+    OutboundQueue sending;          // Messages handed to the kernel by an in-flight send
+    std::vector<iovec> sendSegments;    // Gathered from sending for that send
+    msghdr sendHeader{};
+    int pendingOps = 0;             // Submitted operations that have not completed yet
+    bool recvArmed = false;
+    bool tornDown = false;
+
+    Connection(int fd, ClientType type, bool listening, int loop)
+        : fd(fd), type(type), listening(listening), loop(loop), closed(false), closing(false),
+          upgrading(type == ClientType::WEBSOCKET && !listening), openedAt(std::chrono::steady_clock::now()) {}
+
+    // Output is queued or still in flight (caller holds outputLock)
+    bool backlogged() const { return !output.empty() || !sending.empty(); }
+    size_t pendingBytes() const { return output.bytes() + sending.bytes(); }
+};
+
+// Callbacks from the reactor. onData and onClose for a connection always run on its owning thread;
+// onOpen runs on whichever thread accepted it, before any data is delivered.
+class ConnectionHandler {
+public:
+    virtual ~ConnectionHandler() = default;
+    virtual void onOpen(Connection& conn) = 0;
+    // New bytes were appended to conn.input; consume whatever complete messages it holds
+    virtual void onData(Connection& conn) = 0;
+    // Most bytes conn.input may hold unconsumed. The reactor reads no further ahead than this
+    // before calling onData, and disconnects a client whose input is still this full afterwards.
+    virtual size_t inputLimit(const Connection& conn) const = 0;
+    virtual void onClose(Connection& conn) = 0;
+};
+
+// Network backend: a fixed pool of event loop threads that own every client socket.
+// Connections are looked up by fd in a registry shared by all loops.
+class Reactor {
+public:
+    virtual ~Reactor() = default;
+    Reactor(const Reactor&) = delete;
+    Reactor& operator=(const Reactor&) = delete;
+
+    virtual void listen(int fd, ClientType type) = 0;
+    // Hand over an already accepted socket
+    virtual void adopt(int fd, ClientType type) = 0;
+
+    // Queue a message for the connection. Safe from any thread; returns false if the fd is not an
+    // open connection or its queue is full (which disconnects it).
+    virtual bool send(int fd, OutboundMessage message) = 0;
+    bool send(int fd, const std::string& bytes, uint64_t coalesceKey = 0) {
+        return send(fd, OutboundMessage{bytes, nullptr, coalesceKey});
+    }
+    // Stop reading, flush what is queued and close. Safe from any thread.
+    virtual void close(int fd) = 0;
+
+    // Runs the event loops on the calling thread plus numThreads - 1 others until stop()
+    virtual void run() = 0;
+    virtual void stop() = 0;
+    virtual const char* name() const = 0;
+
+    std::shared_ptr<Connection> find(int fd);
+    int getNumThreads() const { return numThreads; }
+
+protected:
+    Reactor(ConnectionHandler& handler, const ServerConfig& config);
+    void registerConnection(const std::shared_ptr<Connection>& conn);
+    std::shared_ptr<Connection> unregisterConnection(int fd);
+
+    // Caller holds outputLock. Queues the bytes, or disconnects the client if they do not fit.
+    bool enqueue(Connection& conn, OutboundMessage message);
+    // Caller holds outputLock. Shutting down the read side wakes the owning loop, which tears
+    // the connection down; the fd itself is only ever closed there.
+    void requestClose(Connection& conn);
+    // Socket options for a newly accepted client (TCP_NODELAY in low-latency mode)
+    void tuneSocket(int fd);
+    // Periodic tick from each loop: disconnect its clients whose output has made no progress for
+    // slowConsumerTimeout or whose WebSocket handshake is overdue
+    void evictStalled(int loop);
+
+    static const int SWEEP_INTERVAL_MS = 1000;
+
+    ConnectionHandler& handler;
+    int numThreads;
+    OutboundLimits limits;
+    std::chrono::milliseconds slowConsumerTimeout;
+    std::chrono::milliseconds handshakeTimeout;
+    bool lowLatency;
+    std::atomic<bool> running;
+    std::vector<std::shared_ptr<Connection>> listeners;
+
+private:
+    std::shared_mutex registryLock;
+    std::unordered_map<int, std::shared_ptr<Connection>> connections;
+};
+
+// Edge-triggered epoll. Listening sockets are shared by every thread (EPOLLEXCLUSIVE); accepted
+// sockets are non-blocking and spread round-robin. Senders write directly from their own thread.
+class EpollReactor : public Reactor {
+public:
+    EpollReactor(ConnectionHandler& handler, const ServerConfig& config);
+    ~EpollReactor() override;
+
+    void listen(int fd, ClientType type) override;
+    void adopt(int fd, ClientType type) override;
+    using Reactor::send;
+    bool send(int fd, OutboundMessage message) override;
+    void close(int fd) override;
+    void run() override;
+    void stop() override;
+    const char* name() const override { return "epoll"; }
+
+private:
+    struct Loop {
+        int epollFd;
+        int wakeFd;
+    };
+
+    void loop(int index);
+    void acceptAll(Connection& listener);
+    bool readAll(Connection& conn);
+    void flushDeferred();
+    bool flush(Connection& conn);   // Caller holds outputLock
+    void destroy(Connection& conn);
+
+    std::vector<Loop> loops;
+    std::vector<std::thread> threads;
+    std::atomic<unsigned> nextLoop;
+};
+
+// The backend picked by config.io, falling back to epoll when io_uring is unavailable
+std::unique_ptr<Reactor> makeReactor(ConnectionHandler& handler, const ServerConfig& config);
+
+#endif // REACTOR_H
@@ -0,0 +1,241 @@
+#include "request.h"
+#include <cstring>
+#include <cstdint>
+#include <climits>
+#include "json.hpp"
+
+using json = nlohmann::json;
+
+namespace {
+
+constexpr size_t constLength(const char* s) {
+    size_t n = 0;
+    while (s[n] != '\0') {
+        n++;
+    }
+    return n;
+}
+
+constexpr uint32_t hashName(const char* s, size_t n, uint32_t seed) {
+    uint32_t h = 2166136261u ^ seed;
+    for (size_t i = 0; i < n; i++) {
+        h = (h ^ static_cast<uint8_t>(s[i])) * 16777619u;
+    }
+    return h ^ (h >> 15);
+}
+
+// Slot table for a fixed set of names. The seed is searched for at compile time so that every
+// name gets a slot of its own; a lookup is then one hash and one string compare.
+template <size_t N, size_t SLOTS>
+struct PerfectHash {
+    static_assert((SLOTS & (SLOTS - 1)) == 0, "slot count must be a power of two");
+    uint32_t seed = 0;
+    int8_t slots[SLOTS] = {};
+
+    int find(const char* const (&names)[N], const char* s, size_t n) const {
+        int index = slots[hashName(s, n, seed) & (SLOTS - 1)];
+        if (index < 0 || strlen(names[index]) != n || memcmp(names[index], s, n) != 0) {
+            return -1;
+        }
+        return index;
+    }
+};
+
+template <size_t N, size_t SLOTS>
+constexpr PerfectHash<N, SLOTS> buildPerfectHash(const char* const (&names)[N]) {
+    for (uint32_t seed = 0;; seed++) {
+        PerfectHash<N, SLOTS> table;
+        table.seed = seed;
+        for (size_t i = 0; i < SLOTS; i++) {
+            table.slots[i] = -1;
+        }
+        bool collision = false;
+        for (size_t i = 0; i < N && !collision; i++) {
+            size_t slot = hashName(names[i], constLength(names[i]), seed) & (SLOTS - 1);
+            collision = table.slots[slot] >= 0;
+            table.slots[slot] = static_cast<int8_t>(i);
+        }
+        if (!collision) {
+            return table;
+        }
+    }
+}
+
+// Enum order
+constexpr const char* MESSAGE_NAMES[] = {
+    "LOGIN", "REGISTER", "CREATE_GAME", "JOIN_GAME", "EXIT_GAME",
+    "UNREGISTER", "START_GAME", "PLAY_TURN", "LIST_GAMES", "RESYNC"
+};
+constexpr const char* ACTION_NAMES[] = {"FOLD", "CHECK", "CALL", "BET", "RAISE", "ALL_IN"};
+
+enum FieldId {
+#define REQUEST_ID(type, member, key) FIELD_##member,
+    REQUEST_FIELDS(REQUEST_ID)
+#undef REQUEST_ID
+    NUM_FIELDS,
+    NO_FIELD = NUM_FIELDS
+};
+
+constexpr const char* FIELD_KEYS[] = {
+#define REQUEST_KEY(type, member, key) key,
+    REQUEST_FIELDS(REQUEST_KEY)
+#undef REQUEST_KEY
+};
+
+constexpr auto MESSAGE_HASH = buildPerfectHash<10, 32>(MESSAGE_NAMES);
+constexpr auto ACTION_HASH = buildPerfectHash<6, 16>(ACTION_NAMES);
+constexpr auto FIELD_HASH = buildPerfectHash<NUM_FIELDS, 32>(FIELD_KEYS);
+
+static_assert(sizeof(MESSAGE_NAMES) / sizeof(MESSAGE_NAMES[0]) == static_cast<size_t>(MessageType::UNKNOWN),
+              "MESSAGE_NAMES must follow MessageType");
+static_assert(sizeof(ACTION_NAMES) / sizeof(ACTION_NAMES[0]) == static_cast<size_t>(ActionType::UNKNOWN),
+              "ACTION_NAMES must follow ActionType");
+
+[[noreturn]] void wrongType(const char* key) {
+    throw std::runtime_error(std::string("Wrong type for field: ") + key);
+}
+
+// Typed stores for scalar values. The generic overload catches every pairing of field and value
+// type that does not fit. A number outside the range of int, or NaN, is the wrong type as well.
+template <typename T, typename V>
+void assign(Field<T>& field, V&&) {
+    wrongType(field.key);
+}
+void assign(Field<std::string>& field, std::string& value) {
+    field.value = std::move(value);
+    field.present = true;
+}
+void assign(Field<MessageType>& field, std::string& value) {
+    field.value = messageType(value.data(), value.size());
+    field.present = true;
+}
+void assign(Field<ActionType>& field, std::string& value) {
+    field.value = actionType(value.data(), value.size());
+    field.present = true;
+}
+void assign(Field<int>& field, int64_t value) {
+    if (value < INT_MIN || value > INT_MAX) {
+        wrongType(field.key);
+    }
+    field.value = static_cast<int>(value);
+    field.present = true;
+}
+void assign(Field<int>& field, uint64_t value) {
+    if (value > static_cast<uint64_t>(INT_MAX)) {
+        wrongType(field.key);
+    }
+    field.value = static_cast<int>(value);
+    field.present = true;
+}
+void assign(Field<int>& field, double value) {
+    // Written so NaN fails too; fractions truncate as before
+    if (!(value > INT_MIN - 1.0 && value < INT_MAX + 1.0)) {
+        wrongType(field.key);
+    }
+    field.value = static_cast<int>(value);
+    field.present = true;
+}
+
+// SAX consumer: fills the known top-level fields of the request and skips everything else
+class RequestReader {
+public:
+    explicit RequestReader(Request& request) : request(request) {}
+
+    bool null() { return value(nullptr); }
+    bool boolean(bool v) { return value(v); }
+    bool number_integer(json::number_integer_t v) { return value(static_cast<int64_t>(v)); }
+    bool number_unsigned(json::number_unsigned_t v) { return value(static_cast<uint64_t>(v)); }
+    bool number_float(json::number_float_t v, const std::string&) { return value(static_cast<double>(v)); }
+    bool string(std::string& v) { return value(v); }
+    bool binary(json::binary_t& v) { return value(v); }
+
+    bool start_object(size_t) { return open(); }
+    bool end_object() { depth--; return true; }
+    bool start_array(size_t) {
+        if (depth == 0) {
+            throw std::runtime_error("Request must be an object");
+        }
+        return open();
+    }
+    bool end_array() { depth--; return true; }
+
+    bool key(std::string& name) {
+        if (depth == 1) {
+            int index = FIELD_HASH.find(FIELD_KEYS, name.data(), name.size());
+            current = index < 0 ? NO_FIELD : static_cast<FieldId>(index);
+        }
+        return true;
+    }
+
+    bool parse_error(size_t position, const std::string&, const nlohmann::detail::exception& e) {
+        throw std::runtime_error("Malformed request at byte " + std::to_string(position) + ": " + e.what());
+    }
+
+private:
+    Request& request;
+    int depth = 0;
+    FieldId current = NO_FIELD;
+
+    bool open() {
+        if (depth == 1 && current != NO_FIELD) {
+            value(nullptr);     // Objects and arrays never fit a field
+        }
+        depth++;
+        current = NO_FIELD;
+        return true;
+    }
+
+    template <typename V>
+    bool value(V&& v) {
+        if (depth == 0) {
+            throw std::runtime_error("Request must be an object");
+        }
+        if (depth == 1) {
+            switch (current) {
+#define REQUEST_SET(type, member, key) case FIELD_##member: assign(request.member, v); break;
+            REQUEST_FIELDS(REQUEST_SET)
+#undef REQUEST_SET
+            default: break;
+            }
+            current = NO_FIELD;
+        }
+        return true;
+    }
+};
+
+} // namespace
+
+MessageType messageType(const char* name, size_t length) {
+    int index = MESSAGE_HASH.find(MESSAGE_NAMES, name, length);
+    return index < 0 ? MessageType::UNKNOWN : static_cast<MessageType>(index);
+}
+
+ActionType actionType(const char* name, size_t length) {
+    int index = ACTION_HASH.find(ACTION_NAMES, name, length);
+    return index < 0 ? ActionType::UNKNOWN : static_cast<ActionType>(index);
+}
+
+const char* messageName(MessageType type) {
+    return type == MessageType::UNKNOWN ? "UNKNOWN" : MESSAGE_NAMES[static_cast<int>(type)];
+}
+
+const char* actionName(ActionType action) {
+    return action == ActionType::UNKNOWN ? "UNKNOWN" : ACTION_NAMES[static_cast<int>(action)];
+}
+
+void parseRequest(const char* data, size_t length, WireEncoding encoding, Request& request) {
+    request = Request();
+    RequestReader reader(request);
+    const uint8_t* bytes = reinterpret_cast<const uint8_t*>(data);
+    switch (encoding) {
+    case WireEncoding::MSGPACK:
+        json::sax_parse(bytes, bytes + length, &reader, json::input_format_t::msgpack);
+        break;
+    case WireEncoding::CBOR:
+        json::sax_parse(bytes, bytes + length, &reader, json::input_format_t::cbor);
+        break;
+    default:
+        json::sax_parse(data, data + length, &reader);
+        break;
+    }
+}
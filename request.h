@@ -0,0 +1,85 @@
+#ifndef REQUEST_H
+#define REQUEST_H
+
+#include <string>
+#include <cstddef>
+#include <stdexcept>
+#include "reactor.h"
+
+//TODO: Leadership Board, game chat
+enum class MessageType {
+    LOGIN,
+    REGISTER,
+    CREATE_GAME,
+    JOIN_GAME,
+    EXIT_GAME,
+    UNREGISTER,
+    START_GAME,
+    PLAY_TURN,
+    LIST_GAMES,
+    RESYNC,
+    UNKNOWN
+};
+
+enum class ActionType {
+    FOLD,
+    CHECK,
+    CALL,
+    BET,
+    RAISE,
+    ALL_IN,
+    UNKNOWN
+};
+
+// Wire names <-> enums; lookups go through compile-time perfect hashes (one hash, one compare)
+MessageType messageType(const char* name, size_t length);
+ActionType actionType(const char* name, size_t length);
+inline ActionType actionType(const std::string& name) { return actionType(name.data(), name.size()); }
+const char* messageName(MessageType type);
+const char* actionName(ActionType action);
+
+// One request field and whether the message carried it
+template <typename T>
+struct Field {
+    const char* key;
+    T value{};
+    bool present = false;
+
+    // For fields a handler cannot do without; a missing one drops the connection like bad JSON
+    const T& required() const {
+        if (!present) {
+            throw std::runtime_error(std::string("Missing field: ") + key);
+        }
+        return value;
+    }
+    T valueOr(const T& fallback) const { return present ? value : fallback; }
+};
+
+// Every top-level field a client request can carry: (type, member, wire key)
+#define REQUEST_FIELDS(F)                           \
+    F(MessageType, type, "type")                    \
+    F(std::string, name, "name")                    \
+    F(std::string, token, "token")                  \
+    F(std::string, username, "username")            \
+    F(int, gameId, "game_id")                       \
+    F(int, smallBlind, "small_blind")               \
+    F(int, bigBlind, "big_blind")                   \
+    F(std::string, rng, "rng")                      \
+    F(int, startingStack, "starting_stack")         \
+    F(std::string, stateUpdates, "state_updates")   \
+    F(ActionType, action, "action")                 \
+    F(int, amount, "amount")
+
+// A client request with its fields already typed. Parsing is a SAX pass that keeps the fields
+// above and skips anything else, so no json tree is built; a known field with a value of the
+// wrong type is an error.
+struct Request {
+#define REQUEST_DECLARE(type, member, key) Field<type> member{key};
+    REQUEST_FIELDS(REQUEST_DECLARE)
+#undef REQUEST_DECLARE
+};
+
+// Parse one message body (JSON text, MessagePack or CBOR) into request; throws on malformed input
+void parseRequest(const char* data, size_t length, WireEncoding encoding, Request& request);
+
+#endif // REQUEST_H
@@ -0,0 +1,57 @@
+#include "rng.h"
+#include <atomic>
+#include <random>
+#include <stdexcept>
+#include <openssl/rand.h>
+
+// Seeds for FastRng: one random_device read per process, then a counter through splitmix64
+static uint64_t nextFastSeed() {
+    static const uint64_t base = (static_cast<uint64_t>(std::random_device{}()) << 32) ^ std::random_device{}();
+    static std::atomic<uint64_t> counter(0);
+    return base + 0x9E3779B97F4A7C15ULL * (counter++ + 1);
+}
+
+FastRng::FastRng() : gen(nextFastSeed()) {
+}
+
+// SecureRng's batch, one per thread
+struct SecureBatch {
+    uint64_t words[SecureRng::BATCH_WORDS];
+    int pos = SecureRng::BATCH_WORDS;
+};
+
+static thread_local SecureBatch secureBatch;
+
+uint64_t SecureRng::next() {
+    SecureBatch& batch = secureBatch;
+    if(batch.pos == BATCH_WORDS) {
+        if(RAND_bytes(reinterpret_cast<unsigned char*>(batch.words), sizeof(batch.words)) != 1) {
+            throw std::runtime_error("OpenSSL RAND_bytes failed");
+        }
+        batch.pos = 0;
+    }
+    return batch.words[batch.pos++];
+}
+
+std::unique_ptr<DeckRng> makeDeckRng(RngKind kind) {
+    if(kind == RngKind::FAST) {
+        return std::make_unique<FastRng>();
+    }
+    return std::make_unique<SecureRng>();
+}
+
+bool parseRngKind(const std::string& name, RngKind& kind) {
+    if(name == "fast") {
+        kind = RngKind::FAST;
+        return true;
+    }
+    if(name == "secure") {
+        kind = RngKind::SECURE;
+        return true;
+    }
+    return false;
+}
+
+const char* rngKindName(RngKind kind) {
+    return kind == RngKind::FAST ? "fast" : "secure";
+}
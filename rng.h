@@ -0,0 +1,94 @@
+#ifndef RNG_H
+#define RNG_H
+
+#include <cstdint>
+#include <memory>
+#include <string>
+
+// Uniform value in [0, bound) from a 64-bit generator, without modulo bias (Lemire's method)
+template <typename Generator>
+uint32_t uniformBelow(Generator& gen, uint32_t bound) {
+    uint64_t product = (gen.next() >> 32) * bound;
+    uint32_t low = static_cast<uint32_t>(product);
+    if(low < bound) {
+        uint32_t threshold = static_cast<uint32_t>(-bound) % bound;
+        while(low < threshold) {
+            product = (gen.next() >> 32) * bound;
+            low = static_cast<uint32_t>(product);
+        }
+    }
+    return static_cast<uint32_t>(product >> 32);
+}
+
+// xoshiro256** seeded through splitmix64: 32 bytes of state, no syscalls
+class Xoshiro256 {
+public:
+    explicit Xoshiro256(uint64_t seed) {
+        for(auto& word : state) {
+            seed += 0x9E3779B97F4A7C15ULL;
+            uint64_t z = seed;
+            z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+            z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+            word = z ^ (z >> 31);
+        }
+    }
+
+    uint64_t next() {
+        uint64_t result = rotl(state[1] * 5, 7) * 9;
+        uint64_t t = state[1] << 17;
+        state[2] ^= state[0];
+        state[3] ^= state[1];
+        state[1] ^= state[2];
+        state[0] ^= state[3];
+        state[2] ^= t;
+        state[3] = rotl(state[3], 45);
+        return result;
+    }
+
+    uint32_t below(uint32_t bound) { return uniformBelow(*this, bound); }
+
+private:
+    static uint64_t rotl(uint64_t x, int k) { return (x << k) | (x >> (64 - k)); }
+    uint64_t state[4];
+};
+
+// Shuffle randomness for a table. Each Poker owns one, so engines can differ per room.
+class DeckRng {
+public:
+    virtual ~DeckRng() = default;
+    virtual uint64_t next() = 0;
+    uint32_t below(uint32_t bound) { return uniformBelow(*this, bound); }
+};
+
+enum class RngKind {
+    FAST,    // xoshiro256** - simulations, bots, casual tables
+    SECURE   // OpenSSL CSPRNG - tables where dealing must be unpredictable
+};
+
+// Fast engine, seeded from a process-wide sequence (one random_device read per process)
+class FastRng : public DeckRng {
+public:
+    FastRng();
+    explicit FastRng(uint64_t seed) : gen(seed) {}
+    uint64_t next() override { return gen.next(); }
+
+private:
+    Xoshiro256 gen;
+};
+
+// OpenSSL RAND_bytes, refilled in batches so the CSPRNG cost is spread over many hands. The batch
+// belongs to the calling thread and is shared by every table it deals, so a room holds no buffer.
+class SecureRng : public DeckRng {
+public:
+    static const int BATCH_WORDS = 512;  // 4 KB per refill, roughly 80 nine-handed hands
+
+    uint64_t next() override;
+};
+
+std::unique_ptr<DeckRng> makeDeckRng(RngKind kind);
+
+// "fast" / "secure"; returns false for anything else
+bool parseRngKind(const std::string& name, RngKind& kind);
+const char* rngKindName(RngKind kind);
+
+#endif // RNG_H
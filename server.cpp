@@ -1,9 +1,13 @@
 #include "server.h"
 #include "poker.h"
-#include <thread>
+#include "compact.h"
+#include "log.h"
+#include "websocket.h"
+#include "deflate.h"
 #include <mutex>
 #include <algorithm>
 #include <cstring>
+#include <climits>
 #include <openssl/sha.h>
 #include <poll.h>
 
@@ -14,13 +18,214 @@
 #define htobe64(x) OSSwapHostToBigInt64(x)
 #endif
 
-// Global mutex for thread safety
-std::mutex server_mutex;
-
 // WebSocket constants
 static const std::string WS_MAGIC_STRING = "258EAFA5-E914-47DA-95CA-C5AB0DC85B11";
 
-    Server::Server()
+// Length prefix of a TCP message
+static std::string tcpHeader(size_t payloadLength) {
+    uint32_t length = htonl(static_cast<uint32_t>(payloadLength));
+    return std::string(reinterpret_cast<const char*>(&length), sizeof(length));
+}
+
+// Binary encodings travel in WebSocket binary frames; raw TCP framing is the same for all.
+// Writes at most WS_MAX_HEADER bytes and returns how many.
+static size_t writeFrameHeader(char* out, ClientType type, WireEncoding encoding, size_t payloadLength,
+                               bool compressed = false) {
+    if (type == ClientType::WEBSOCKET) {
+        return writeWebSocketHeader(out, payloadLength, encoding != WireEncoding::JSON, compressed);
+    }
+    uint32_t length = htonl(static_cast<uint32_t>(payloadLength));
+    memcpy(out, &length, sizeof(length));
+    return sizeof(length);
+}
+
+static std::string frameHeader(ClientType type, WireEncoding encoding, size_t payloadLength,
+                               bool compressed = false) {
+    char header[WS_MAX_HEADER];
+    return std::string(header, writeFrameHeader(header, type, encoding, payloadLength, compressed));
+}
+
+// WebSocket subprotocol names a client can offer for its encoding
+static bool parseEncodingName(const std::string& name, WireEncoding& encoding) {
+    if (name == "json")    { encoding = WireEncoding::JSON;    return true; }
+    if (name == "msgpack") { encoding = WireEncoding::MSGPACK; return true; }
+    if (name == "cbor")    { encoding = WireEncoding::CBOR;    return true; }
+    return false;
+}
+
+// Flag byte a raw TCP client can open the connection with
+static bool parseEncodingFlag(char flag, WireEncoding& encoding) {
+    if (flag == 'J') { encoding = WireEncoding::JSON;    return true; }
+    if (flag == 'M') { encoding = WireEncoding::MSGPACK; return true; }
+    if (flag == 'C') { encoding = WireEncoding::CBOR;    return true; }
+    if (flag == 'B') { encoding = WireEncoding::COMPACT; return true; }
+    return false;
+}
+
+static const int NUM_ENCODINGS = 4;
+
+// Largest HTTP upgrade request accepted from a WebSocket client
+static const size_t MAX_HANDSHAKE_BYTES = 8192;
+// Largest WebSocket message, after its fragments are put together (and after inflating)
+static const uint64_t MAX_WS_MESSAGE_BYTES = 1000000;
+// Room for the frame headers and control frames received along with an open WebSocket message
+static const size_t MAX_WS_FRAMING_BYTES = 64 * 1024;
+// Largest raw TCP message body, after its 4-byte length
+static const uint32_t MAX_TCP_MESSAGE_BYTES = 1000000;
+// permessage-deflate clients get messages this size and up compressed; below it deflate saves
+// next to nothing
+static const size_t DEFLATE_MIN_BYTES = 128;
+
+// Appends the encoded message to out. Compact connections exchange JSON for anything outside the
+// compact schema.
+static void encodeMessage(std::string& out, const json& message, WireEncoding encoding) {
+    switch (encoding) {
+    case WireEncoding::MSGPACK:
+        json::to_msgpack(message, out);
+        break;
+    case WireEncoding::CBOR:
+        json::to_cbor(message, out);
+        break;
+    default:
+        out += message.dump();
+        break;
+    }
+}
+
+static std::string encodeMessage(const json& message, WireEncoding encoding) {
+    std::string out;
+    encodeMessage(out, message, encoding);
+    return out;
+}
+
+// Encodes a payload behind room for the largest frame header, for framedMessage
+static std::string encodeWithRoom(const json& message, WireEncoding encoding) {
+    std::string buffer(WS_MAX_HEADER, '\0');
+    encodeMessage(buffer, message, encoding);
+    return buffer;
+}
+
+// Writes the header for the payload in buffer into the end of the room in front of it, so the
+// whole frame is one buffer and nothing is copied after encoding
+static OutboundMessage framedMessage(std::string buffer, ClientType type, WireEncoding encoding,
+                                     uint64_t coalesceKey, bool compressed = false) {
+    char header[WS_MAX_HEADER];
+    size_t headerLength = writeFrameHeader(header, type, encoding, buffer.size() - WS_MAX_HEADER, compressed);
+    size_t start = WS_MAX_HEADER - headerLength;
+    memcpy(&buffer[start], header, headerLength);
+    return OutboundMessage{std::move(buffer), nullptr, coalesceKey, start};
+}
+
+// One broadcast body compressed for the deflate clients with a given window, and its frame header
+struct DeflatedBody {
+    std::shared_ptr<const std::string> body;
+    std::string head;
+};
+
+static DeflatedBody& deflatedBody(DeflatedBody (&cache)[DEFLATE_MAX_WINDOW_BITS + 1], const Player& player,
+                                  const std::string& body) {
+    const DeflateParams& params = player.deflate->params;
+    DeflatedBody& deflated = cache[params.serverWindowBits];
+    if (!deflated.body) {
+        std::string out;
+        deflateStandalone(body.data(), body.size(), player.deflate->level, params.serverWindowBits, out);
+        deflated.body = std::make_shared<const std::string>(std::move(out));
+        deflated.head = frameHeader(ClientType::WEBSOCKET, player.encoding, deflated.body->size(), true);
+    }
+    return deflated;
+}
+
+// Length of the map header at the start of an encoded object (MessagePack or CBOR)
+static size_t mapHeaderLength(const std::string& encoded, WireEncoding encoding) {
+    uint8_t first = static_cast<uint8_t>(encoded[0]);
+    if (encoding == WireEncoding::MSGPACK) {
+        return first == 0xDE ? 3 : first == 0xDF ? 5 : 1;
+    }
+    switch (first) {
+    case 0xB8: return 2;
+    case 0xB9: return 3;
+    case 0xBA: return 5;
+    case 0xBB: return 9;
+    default:   return 1;
+    }
+}
+
+// Map header for an object with count entries, in the smallest form (as json.hpp writes it)
+static std::string mapHeader(size_t count, WireEncoding encoding) {
+    std::string header;
+    auto bigEndian = [&](uint64_t value, int bytes) {
+        for (int i = bytes - 1; i >= 0; i--) {
+            header.push_back(static_cast<char>((value >> (i * 8)) & 0xFF));
+        }
+    };
+    if (encoding == WireEncoding::MSGPACK) {
+        if (count < 16) {
+            header.push_back(static_cast<char>(0x80 | count));
+        } else if (count <= 0xFFFF) {
+            header.push_back(static_cast<char>(0xDE));
+            bigEndian(count, 2);
+        } else {
+            header.push_back(static_cast<char>(0xDF));
+            bigEndian(count, 4);
+        }
+    } else if (count < 24) {
+        header.push_back(static_cast<char>(0xA0 | count));
+    } else if (count <= 0xFF) {
+        header.push_back(static_cast<char>(0xB8));
+        bigEndian(count, 1);
+    } else if (count <= 0xFFFF) {
+        header.push_back(static_cast<char>(0xB9));
+        bigEndian(count, 2);
+    } else {
+        header.push_back(static_cast<char>(0xBA));
+        bigEndian(count, 4);
+    }
+    return header;
+}
+
+// Value of an HTTP request header (name matched case-insensitively), or "" if absent
+static std::string headerValue(const std::string& request, const std::string& name) {
+    std::string lower = request;
+    std::transform(lower.begin(), lower.end(), lower.begin(), ::tolower);
+    std::string needle = "\r\n" + name + ":";
+    std::transform(needle.begin(), needle.end(), needle.begin(), ::tolower);
+    size_t pos = lower.find(needle);
+    if (pos == std::string::npos) {
+        return "";
+    }
+    size_t start = request.find_first_not_of(" \t", pos + needle.size());
+    size_t end = request.find("\r\n", pos + needle.size());
+    if (start == std::string::npos || start >= end) {
+        return "";
+    }
+    size_t last = request.find_last_not_of(" \t", end - 1);
+    return request.substr(start, last + 1 - start);
+}
+
+// Request bytes for TRACE logs: JSON as text, other encodings by size only
+struct PayloadText {
+    const char* data;
+    size_t length;
+};
+
+static std::ostream& operator<<(std::ostream& os, const PayloadText& payload) {
+    if (payload.length > 0 && payload.data[0] == '{') {
+        return os.write(payload.data, payload.length);
+    }
+    return os << payload.length << " binary bytes";
+}
+
+static uint8_t seatFlags(const Player& player) {
+    return (player.isActive ? compact::SEAT_ACTIVE : 0) | (player.hasHand ? compact::SEAT_HAS_HAND : 0);
+}
+
+// A client that has not read a room's last GAME_STATE_UPDATE only needs the newest one
+static uint64_t stateUpdateKey(int game_id) {
+    return (static_cast<uint64_t>(game_id) << 1) | 1;
+}
+
+    Server::Server(const ServerConfig& config)
+        : config(config), reactor(makeReactor(*this, config))
     {
         nextGameID = 1;
         
@@ -28,7 +233,7 @@ static const std::string WS_MAGIC_STRING = "258EAFA5-E914-47DA-95CA-C5AB0DC85B11
         server_fd = socket(AF_INET, SOCK_STREAM, 0);
         if (server_fd == 0)
         {
-            cerr << "Socket creation error" << endl;
+            LOG_ERROR(SERVER, "Socket creation error");
             exit(EXIT_FAILURE);
         }
 
@@ -36,7 +241,7 @@ static const std::string WS_MAGIC_STRING = "258EAFA5-E914-47DA-95CA-C5AB0DC85B11
         int opt = 1;
         if (setsockopt(server_fd, SOL_SOCKET, SO_REUSEADDR, &opt, sizeof(opt)))
         {
-            cerr << "TCP setsockopt SO_REUSEADDR error" << endl;
+            LOG_ERROR(SERVER, "TCP setsockopt SO_REUSEADDR error");
             exit(EXIT_FAILURE);
         }
         
@@ -44,43 +249,43 @@ static const std::string WS_MAGIC_STRING = "258EAFA5-E914-47DA-95CA-C5AB0DC85B11
         if (setsockopt(server_fd, SOL_SOCKET, SO_REUSEPORT, &opt, sizeof(opt)))
         {
             // SO_REUSEPORT is optional - just warn if it fails
-            cerr << "Warning: TCP setsockopt SO_REUSEPORT failed (non-critical)" << endl;
+            LOG_WARN(SERVER, "Warning: TCP setsockopt SO_REUSEPORT failed (non-critical)");
         }
     #endif
 
-        // Setup address for TCP (port 8080)
+        // Setup address for TCP (port 8080 by default)
         sockaddr_in serverAddress;
         serverAddress.sin_family = AF_INET;
-        serverAddress.sin_port = htons(8080);
+        serverAddress.sin_port = htons(config.tcpPort);
         serverAddress.sin_addr.s_addr = INADDR_ANY;
 
         // Bind TCP socket
         if (bind(server_fd, (struct sockaddr *)&serverAddress, sizeof(serverAddress)) < 0)
         {
-            cerr << "TCP Bind failed" << endl;
+            LOG_ERROR(SERVER, "TCP Bind failed");
             exit(EXIT_FAILURE);
         }
 
         // Listen on TCP
-        if (listen(server_fd, 10) < 0)
+        if (listen(server_fd, SOMAXCONN) < 0)
         {
-            cerr << "TCP Listen failed" << endl;
+            LOG_ERROR(SERVER, "TCP Listen failed");
             exit(EXIT_FAILURE);
         }
 
-        cout << "TCP Server started on port 8080" << endl;
+        LOG_INFO(SERVER, "TCP Server started on port " << config.tcpPort);
         
-        // Create WebSocket server socket (port 8081)
+        // Create WebSocket server socket (port 8081 by default)
         ws_server_fd = socket(AF_INET, SOCK_STREAM, 0);
         if (ws_server_fd == 0)
         {
-            cerr << "WebSocket socket creation error" << endl;
+            LOG_ERROR(SERVER, "WebSocket socket creation error");
             exit(EXIT_FAILURE);
         }
 
         if (setsockopt(ws_server_fd, SOL_SOCKET, SO_REUSEADDR, &opt, sizeof(opt)))
         {
-            cerr << "WebSocket setsockopt SO_REUSEADDR error" << endl;
+            LOG_ERROR(SERVER, "WebSocket setsockopt SO_REUSEADDR error");
             exit(EXIT_FAILURE);
         }
         
@@ -88,28 +293,38 @@ static const std::string WS_MAGIC_STRING = "258EAFA5-E914-47DA-95CA-C5AB0DC85B11
         if (setsockopt(ws_server_fd, SOL_SOCKET, SO_REUSEPORT, &opt, sizeof(opt)))
         {
             // SO_REUSEPORT is optional - just warn if it fails
-            cerr << "Warning: WebSocket setsockopt SO_REUSEPORT failed (non-critical)" << endl;
+            LOG_WARN(SERVER, "Warning: WebSocket setsockopt SO_REUSEPORT failed (non-critical)");
         }
     #endif
 
         sockaddr_in wsAddress;
         wsAddress.sin_family = AF_INET;
-        wsAddress.sin_port = htons(8081);
+        wsAddress.sin_port = htons(config.wsPort);
         wsAddress.sin_addr.s_addr = INADDR_ANY;
 
         if (bind(ws_server_fd, (struct sockaddr *)&wsAddress, sizeof(wsAddress)) < 0)
         {
-            cerr << "WebSocket Bind failed" << endl;
+            LOG_ERROR(SERVER, "WebSocket Bind failed");
             exit(EXIT_FAILURE);
         }
 
-        if (listen(ws_server_fd, 10) < 0)
+        if (listen(ws_server_fd, SOMAXCONN) < 0)
         {
-            cerr << "WebSocket Listen failed" << endl;
+            LOG_ERROR(SERVER, "WebSocket Listen failed");
             exit(EXIT_FAILURE);
         }
 
-        cout << "WebSocket Server started on port 8081" << endl;
+        LOG_INFO(SERVER, "WebSocket Server started on port " << config.wsPort);
+
+        // Preflop all-in equities are precomputed by preflop_gen; lookups are O(1) once mapped
+        if (preflopTable.load("preflop_equity.bin"))
+        {
+            LOG_INFO(SERVER, "Loaded preflop equity table");
+        }
+        else
+        {
+            LOG_INFO(SERVER, "No preflop equity table (run `make preflop_equity.bin`), all-in equity disabled");
+        }
     }
 
 Server::~Server()
@@ -149,391 +364,613 @@ std::string Server::base64Encode(const unsigned char* data, size_t len) {
     return result;
 }
 
-bool Server::performWebSocketHandshake(int client_fd) {
-    char buffer[4096];
-    ssize_t received = recv(client_fd, buffer, sizeof(buffer) - 1, 0);
-    if (received <= 0) return false;
-    buffer[received] = '\0';
-    
-    std::string request(buffer);
-    
-    // Find Sec-WebSocket-Key header (try different capitalizations)
-    std::string key_header = "Sec-WebSocket-Key: ";
-    size_t key_pos = request.find(key_header);
-    
-    if (key_pos == std::string::npos) {
-        key_header = "Sec-Websocket-Key: ";
-        key_pos = request.find(key_header);
+// Upgrades a WebSocket connection once its whole HTTP request has arrived. Each call only
+// searches the bytes received since the last one for the end of the headers, and returns false
+// until it is found. A request that is too large or has no key is answered with 400 and throws.
+bool Server::performWebSocketHandshake(Connection& conn, size_t& offset) {
+    static const char HEADER_END[] = "\r\n\r\n";
+    static const std::string BAD_REQUEST = "HTTP/1.1 400 Bad Request\r\nConnection: close\r\n\r\n";
+
+    const char* begin = conn.input.data();
+    const char* last = begin + conn.input.size();
+    size_t from = std::max(offset, conn.scanned >= 3 ? conn.scanned - 3 : 0);
+    const char* end = std::search(begin + from, last, HEADER_END, HEADER_END + 4);
+    size_t length = end - begin - offset;
+    if (length > MAX_HANDSHAKE_BYTES) {
+        reactor->send(conn.fd, BAD_REQUEST);
+        throw std::runtime_error("WebSocket handshake failed: request headers too large");
+    }
+    if (end == last) {
+        conn.scanned = conn.input.size();
+        return false;
     }
-    if (key_pos == std::string::npos) {
-        key_header = "sec-websocket-key: ";
-        key_pos = request.find(key_header);
+
+    // Up to and including the CRLF that ends the last header line
+    std::string request(begin + offset, end + 2);
+    std::string key = headerValue(request, "Sec-WebSocket-Key");
+    if (key.empty()) {
+        reactor->send(conn.fd, BAD_REQUEST);
+        throw std::runtime_error("WebSocket handshake failed: no Sec-WebSocket-Key");
     }
-    
-    if (key_pos == std::string::npos) return false;
-    
-    size_t key_start = key_pos + key_header.length();
-    size_t key_end = request.find("\r\n", key_start);
-    std::string key = request.substr(key_start, key_end - key_start);
-    
+
     // Generate accept key
     std::string accept_key_input = key + WS_MAGIC_STRING;
     unsigned char hash[SHA_DIGEST_LENGTH];
     SHA1(reinterpret_cast<const unsigned char*>(accept_key_input.c_str()), 
          accept_key_input.length(), hash);
     std::string accept_key = base64Encode(hash, SHA_DIGEST_LENGTH);
+
+    // Encoding: the first offered subprotocol we support ("msgpack", "cbor" or "json") is echoed
+    WireEncoding encoding = WireEncoding::JSON;
+    std::string protocol;
+    std::string offered = headerValue(request, "Sec-WebSocket-Protocol");
+    size_t start = 0;
+    while (start < offered.size() && protocol.empty()) {
+        size_t comma = offered.find(',', start);
+        size_t end = comma == std::string::npos ? offered.size() : comma;
+        size_t first = offered.find_first_not_of(' ', start);
+        size_t last = offered.find_last_not_of(' ', end - 1);
+        if (first < end && last != std::string::npos && last >= first) {
+            std::string name = offered.substr(first, last + 1 - first);
+            if (parseEncodingName(name, encoding)) {
+                protocol = name;
+            }
+        }
+        start = end + 1;
+    }
     
+    // Compression: the first permessage-deflate offer we can honour
+    std::string extensions;
+    if (config.wsDeflateLevel > 0) {
+        DeflateParams params;
+        extensions = negotiateDeflate(headerValue(request, "Sec-WebSocket-Extensions"),
+                                      config.wsDeflateWindowBits, params);
+        if (!extensions.empty()) {
+            conn.deflate = std::make_shared<DeflateSession>(params, config.wsDeflateLevel);
+        }
+    }
+
     // Send handshake response
     std::string response = 
         "HTTP/1.1 101 Switching Protocols\r\n"
         "Upgrade: websocket\r\n"
         "Connection: Upgrade\r\n"
-        "Sec-WebSocket-Accept: " + accept_key + "\r\n\r\n";
-    
-    send(client_fd, response.c_str(), response.length(), 0);
+        "Sec-WebSocket-Accept: " + accept_key + "\r\n";
+    if (!protocol.empty()) {
+        response += "Sec-WebSocket-Protocol: " + protocol + "\r\n";
+    }
+    if (!extensions.empty()) {
+        response += "Sec-WebSocket-Extensions: " + extensions + "\r\n";
+    }
+    response += "\r\n";
+    reactor->send(conn.fd, response);
+
+    conn.encoding = encoding;
+    conn.upgrading = false;
+    conn.scanned = 0;
+    offset = end + 4 - begin;
+    LOG_INFO(NET, "WebSocket handshake successful: fd=" << conn.fd);
     return true;
 }
 
-json Server::receiveWebSocketMessage(int client_fd) {
-    unsigned char header[2];
-    ssize_t received = recv(client_fd, header, 2, MSG_WAITALL);
-    if (received <= 0) throw std::runtime_error("Client disconnected");
-  
-    int opcode = header[0] & 0x0F;
-    bool masked = (header[1] & 0x80) != 0;
-    uint64_t payload_len = header[1] & 0x7F;
-    
-    // Handle close frame
-    if (opcode == 8) {
-        throw std::runtime_error("Client closed connection");
-    }
-    
-    // Handle ping frame
-    if (opcode == 9) {
-        // Send pong
-        unsigned char pong[2] = {0x8A, 0x00};
-        send(client_fd, pong, 2, 0);
-        return receiveWebSocketMessage(client_fd);  // Continue waiting for real message
-    }
-    
-    // Get extended payload length
-    if (payload_len == 126) {
-        uint16_t len16;
-        recv(client_fd, &len16, 2, MSG_WAITALL);
-        payload_len = ntohs(len16);
-    } else if (payload_len == 127) {
-        uint64_t len64;
-        recv(client_fd, &len64, 8, MSG_WAITALL);
-        payload_len = be64toh(len64);
-    }
-    
-    // Get mask key if present
-    unsigned char mask[4] = {0};
-    if (masked) {
-        recv(client_fd, mask, 4, MSG_WAITALL);
-    }
-    
-    // Get payload
-    std::vector<char> payload(payload_len);
-    if (payload_len > 0) {
-        received = recv(client_fd, payload.data(), payload_len, MSG_WAITALL);
-        if (received <= 0) throw std::runtime_error("Client disconnected");
-        
-        // Unmask data
+// Decodes frames in place from conn.input, as many as have fully arrived. Payloads are unmasked
+// where they lie. A fragmented message is kept open across calls: each later fragment is moved
+// down against the ones before it, so the message ends up contiguous behind its first header.
+// Control frames may come between fragments; they are answered and skipped.
+bool Server::nextWebSocketMessage(Connection& conn, size_t& offset, Request& request) {
+    InputBuffer& input = conn.input;
+    while (true) {
+        size_t at = offset + conn.fragmentEnd;
+        size_t available = input.size() - at;
+        if (available < 2) return false;
+        unsigned char* frame = reinterpret_cast<unsigned char*>(input.data() + at);
+
+        bool fin = (frame[0] & 0x80) != 0;
+        bool rsv1 = (frame[0] & 0x40) != 0;
+        int opcode = frame[0] & 0x0F;
+        // RSV1 marks a compressed message, set on its first frame only; RSV2 and RSV3 are unused
+        if ((frame[0] & 0x30) != 0 || (rsv1 && (!conn.deflate || opcode == 0 || opcode >= 8))) {
+            throw std::runtime_error("Unexpected reserved bits in frame");
+        }
+        bool masked = (frame[1] & 0x80) != 0;
+        uint64_t payload_len = frame[1] & 0x7F;
+        size_t header_len = 2;
+
+        // Get extended payload length
+        if (payload_len == 126) {
+            if (available < 4) return false;
+            payload_len = (static_cast<uint64_t>(frame[2]) << 8) | frame[3];
+            header_len = 4;
+        } else if (payload_len == 127) {
+            if (available < 10) return false;
+            uint64_t len64;
+            memcpy(&len64, frame + 2, 8);
+            payload_len = be64toh(len64);
+            header_len = 10;
+        }
+
+        if (payload_len > MAX_WS_MESSAGE_BYTES - conn.fragmentLength) {
+            throw std::runtime_error("Message too large");
+        }
+
+        // Get mask key if present
+        unsigned char mask[4] = {0};
+        if (masked) {
+            if (available < header_len + 4) return false;
+            memcpy(mask, frame + header_len, 4);
+            header_len += 4;
+        }
+
+        if (available < header_len + payload_len) return false;
+        unsigned char* payload = frame + header_len;
         if (masked) {
-            for (size_t i = 0; i < payload_len; i++) {
-                payload[i] ^= mask[i % 4];
+            unmaskPayload(payload, payload_len, mask);
+        }
+
+        if (opcode >= 8) {
+            if (!fin || payload_len > 125) {
+                throw std::runtime_error("Malformed control frame");
             }
+            // Skip over it: past it if no message is open, otherwise it stays inside the open one
+            if (conn.fragmentOpcode == 0) {
+                offset += header_len + payload_len;
+            } else {
+                conn.fragmentEnd += header_len + payload_len;
+            }
+
+            // Handle close frame
+            if (opcode == 8) {
+                throw std::runtime_error("Client closed connection");
+            }
+            // Handle ping frame, then keep looking for a real message; pongs are unsolicited
+            if (opcode == 9) {
+                std::string pong = {static_cast<char>(0x8A), static_cast<char>(payload_len)};
+                pong.append(reinterpret_cast<const char*>(payload), payload_len);
+                reactor->send(conn.fd, pong);
+            }
+            continue;
         }
-    }
-    
-    std::string json_str(payload.begin(), payload.end());
-    return json::parse(json_str);
-}
 
-void Server::sendWebSocketMessage(int client_fd, const json& message) {
-    std::string payload = message.dump();
-    std::vector<unsigned char> frame;
-    
-    cout << "Sending WebSocket message, payload length: " << payload.length() << endl;
-    
-    frame.push_back(0x81);
-    
-    // Payload length (server doesn't mask)
-    if (payload.length() < 126) {
-        frame.push_back(static_cast<unsigned char>(payload.length()));
-        cout << "Using short length format" << endl;
-    } else if (payload.length() < 65536) {
-        frame.push_back(126);
-        frame.push_back((payload.length() >> 8) & 0xFF);
-        frame.push_back(payload.length() & 0xFF);
-        cout << "Using 16-bit length format" << endl;
-    } else {
-        frame.push_back(127);
-        uint64_t len = payload.length();
-        for (int i = 7; i >= 0; i--) {
-            frame.push_back((len >> (i * 8)) & 0xFF);
+        if (opcode == 0) {
+            if (conn.fragmentOpcode == 0) {
+                throw std::runtime_error("Continuation frame outside a message");
+            }
+            memmove(input.data() + offset + conn.fragmentStart + conn.fragmentLength, payload, payload_len);
+        } else if (opcode == 1 || opcode == 2) {
+            if (conn.fragmentOpcode != 0) {
+                throw std::runtime_error("New message before the previous one was finished");
+            }
+            conn.fragmentOpcode = opcode;
+            conn.fragmentCompressed = rsv1;
+            conn.fragmentStart = header_len;
+        } else {
+            throw std::runtime_error("Unknown WebSocket opcode");
+        }
+        conn.fragmentLength += payload_len;
+        conn.fragmentEnd += header_len + payload_len;
+        if (!fin) {
+            continue;
         }
-        cout << "Using 64-bit length format" << endl;
-    }
-    
-    // Payload
-    frame.insert(frame.end(), payload.begin(), payload.end());
-    
-    ssize_t sent = send(client_fd, frame.data(), frame.size(), 0);
-    cout << "Sent " << sent << " bytes (frame size: " << frame.size() << ")" << endl;
-}
 
-MessageType Server::getMessageType(const std::string &typeStr)
-{
-    if (typeStr == "LOGIN")              return MessageType::LOGIN;
-    if (typeStr == "REGISTER")           return MessageType::REGISTER;
-    if (typeStr == "CREATE_GAME")        return MessageType::CREATE_GAME;
-    if (typeStr == "JOIN_GAME")          return MessageType::JOIN_GAME;
-    if (typeStr == "EXIT_GAME")          return MessageType::EXIT_GAME;
-    if (typeStr == "UNREGISTER")         return MessageType::UNREGISTER;
-    if (typeStr == "START_GAME")         return MessageType::START_GAME;
-    if (typeStr == "PLAY_TURN")          return MessageType::PLAY_TURN;
-    if (typeStr == "LIST_GAMES")         return MessageType::LIST_GAMES;
-    return MessageType::UNKNOWN;
-}
+        const char* message = input.data() + offset + conn.fragmentStart;
+        size_t length = conn.fragmentLength;
+        // Binary frames carry the negotiated encoding; text frames are always JSON
+        WireEncoding encoding = conn.fragmentOpcode == 2 ? conn.encoding : WireEncoding::JSON;
+        bool compressed = conn.fragmentCompressed;
+        offset += conn.fragmentEnd;
+        conn.fragmentOpcode = 0;
+        conn.fragmentCompressed = false;
+        conn.fragmentStart = conn.fragmentLength = conn.fragmentEnd = 0;
+
+        std::string inflated;
+        if (compressed) {
+            if (!conn.deflate->decompress(message, length, inflated, MAX_WS_MESSAGE_BYTES)) {
+                throw std::runtime_error("Malformed or oversized compressed message");
+            }
+            message = inflated.data();
+            length = inflated.size();
+        }
 
-ActionType Server::getActionType(const std::string &typeStr) {
-    if(typeStr == "ALL_IN")       return ActionType::ALL_IN;
-    if(typeStr == "FOLD")         return ActionType::FOLD;
-    if(typeStr == "CALL")         return ActionType::CALL;
-    if(typeStr == "CHECK")        return ActionType::CHECK;
-    if(typeStr == "RAISE")        return ActionType::RAISE;
-    if(typeStr == "BET")          return ActionType::BET;
-    return ActionType::UNKNOWN;
+        LOG_TRACE(MSG, "Payload from fd=" << conn.fd << ": " << PayloadText{message, length});
+        parseRequest(message, length, encoding, request);
+        return true;
+    }
 }
 
-json Server::receiveMessage(int clientSocket)
+bool Server::nextMessage(Connection& conn, size_t& offset, Request& request)
 {
-    auto it = clientTypes.find(clientSocket);
-    if (it != clientTypes.end() && it->second == ClientType::WEBSOCKET) {
-        return receiveWebSocketMessage(clientSocket);
+    if (conn.type == ClientType::WEBSOCKET) {
+        if (conn.upgrading && !performWebSocketHandshake(conn, offset)) {
+            return false;
+        }
+        return nextWebSocketMessage(conn, offset, request);
     }
     
-    // TCP message
-    uint32_t msg_length_net;
-    ssize_t received = recv(clientSocket, &msg_length_net, sizeof(msg_length_net), MSG_WAITALL);
-    if (received <= 0)
-    {
-        throw std::runtime_error("Client disconnected");
+    // A raw TCP client may open with one flag byte picking its encoding ('J', 'M', 'C' or 'B'), which is
+    // echoed back. JSON clients start straight with a length prefix, whose first byte is always 0
+    // under the message size cap.
+    if (!conn.encodingChosen) {
+        if (conn.input.size() - offset < 1) {
+            return false;
+        }
+        char flag = conn.input[offset];
+        if (parseEncodingFlag(flag, conn.encoding)) {
+            offset++;
+            reactor->send(conn.fd, std::string(1, flag));
+        }
+        conn.encodingChosen = true;
     }
 
-    uint32_t msg_length = ntohl(msg_length_net);
-    
-    if (msg_length > 1000000) {
-        throw std::runtime_error("Message too large");
-    }
-    
-    std::vector<char> buffer(msg_length);
+    // TCP message: 4-byte big-endian length, then the body in the connection's encoding.
+    // Compact schema messages never become JSON: they are handled here and skipped over.
+    while (true) {
+        if (conn.input.size() - offset < sizeof(uint32_t)) {
+            return false;
+        }
+        uint32_t msg_length_net;
+        memcpy(&msg_length_net, conn.input.data() + offset, sizeof(msg_length_net));
+        uint32_t msg_length = ntohl(msg_length_net);
+        
+        if (msg_length > MAX_TCP_MESSAGE_BYTES) {
+            throw std::runtime_error("Message too large");
+        }
+        
+        if (conn.input.size() - offset < sizeof(uint32_t) + msg_length) {
+            return false;
+        }
 
-    received = recv(clientSocket, buffer.data(), msg_length, MSG_WAITALL);
-    if (received <= 0)
-    {
-        throw std::runtime_error("Client disconnected");
+        const char* body = conn.input.data() + offset + sizeof(uint32_t);
+        offset += sizeof(uint32_t) + msg_length;
+        LOG_TRACE(MSG, "Payload from fd=" << conn.fd << ": " << PayloadText{body, msg_length});
+        if (conn.encoding == WireEncoding::COMPACT && (msg_length == 0 || body[0] != '{')) {
+            dispatchCompact(conn, body, msg_length);
+            if (conn.closing) {
+                return false;
+            }
+            continue;
+        }
+        parseRequest(body, msg_length, conn.encoding, request);
+        return true;
     }
-
-    std::string json_str(buffer.begin(), buffer.end());
-    return json::parse(json_str);
 }
 
-void Server::sendMessage(int clientSocket, const json &message)
+void Server::sendMessage(int clientSocket, const json &message, uint64_t coalesceKey)
 {
-    auto it = clientTypes.find(clientSocket);
-    if (it != clientTypes.end() && it->second == ClientType::WEBSOCKET) {
-        sendWebSocketMessage(clientSocket, message);
+    std::shared_ptr<Connection> conn = reactor->find(clientSocket);
+    if (!conn) {
+        return;  // Already disconnected
+    }
+    LOG_TRACE(MSG, "Sending to fd=" << clientSocket << ": " << message.dump());
+    std::string buffer = encodeWithRoom(message, conn->encoding);
+    size_t payloadLength = buffer.size() - WS_MAX_HEADER;
+    if (!conn->deflate || payloadLength < DEFLATE_MIN_BYTES) {
+        reactor->send(clientSocket, framedMessage(std::move(buffer), conn->type, conn->encoding, coalesceKey));
         return;
     }
-    
-    // TCP message
-    std::string jsonString = message.dump();
-    uint32_t length = htonl(jsonString.size());
 
-    ssize_t bytesSent = send(clientSocket, &length, sizeof(length), 0);
-    if (bytesSent != sizeof(length))
-    {
-        throw std::runtime_error("Failed to send message length");
+    // Compressed with the connection's context, unless a newer message may replace this one
+    // before it is sent: the context must never refer to a message the client did not get
+    DeflateSession& deflate = *conn->deflate;
+    std::string compressed(WS_MAX_HEADER, '\0');
+    std::lock_guard<std::mutex> lock(deflate.lock);
+    if (coalesceKey == 0) {
+        deflate.compress(buffer.data() + WS_MAX_HEADER, payloadLength, compressed);
+    } else {
+        deflateStandalone(buffer.data() + WS_MAX_HEADER, payloadLength, deflate.level,
+                          deflate.params.serverWindowBits, compressed);
+        deflate.queuedStandalone();
     }
+    reactor->send(clientSocket, framedMessage(std::move(compressed), conn->type, conn->encoding, coalesceKey, true));
+}
 
-    bytesSent = send(clientSocket, jsonString.c_str(), jsonString.length(), 0);
-    if (bytesSent != (ssize_t)jsonString.length())
-    {
-        throw std::runtime_error("Failed to send message");
+// Recipients are grouped by encoding: each body is encoded once and each header built once
+void Server::broadcast(const GameRoom& room, const json& message, uint64_t coalesceKey,
+                       const std::function<bool(const Player&)>& include,
+                       const std::function<std::string()>& compactBody)
+{
+    std::shared_ptr<const std::string> bodies[NUM_ENCODINGS];
+    std::string heads[2][NUM_ENCODINGS];
+    DeflatedBody deflated[NUM_ENCODINGS][DEFLATE_MAX_WINDOW_BITS + 1];
+    for (const auto& player : room.players) {
+        if (include && !include(player)) {
+            continue;
+        }
+        int encoding = static_cast<int>(player.encoding);
+        std::shared_ptr<const std::string>& body = bodies[encoding];
+        if (!body) {
+            bool compact = player.encoding == WireEncoding::COMPACT && compactBody;
+            body = std::make_shared<const std::string>(compact ? compactBody()
+                                                               : encodeMessage(message, player.encoding));
+        }
+        // Compressed once per window size, standalone so that every such client can inflate it
+        if (player.deflate && body->size() >= DEFLATE_MIN_BYTES) {
+            DeflatedBody& compressed = deflatedBody(deflated[encoding], player, *body);
+            std::lock_guard<std::mutex> lock(player.deflate->lock);
+            player.deflate->queuedStandalone();
+            reactor->send(player.server_fd, OutboundMessage{compressed.head, compressed.body, coalesceKey});
+            continue;
+        }
+
+        std::string& head = heads[player.clientType == ClientType::WEBSOCKET][encoding];
+        if (head.empty()) {
+            head = frameHeader(player.clientType, player.encoding, body->size());
+        }
+        reactor->send(player.server_fd, OutboundMessage{head, body, coalesceKey});
     }
 }
 
-void Server::run()
+// Objects are joined at the byte level. In JSON the shared body is the object without its "{",
+// and each copy starts "{<private pairs>,". In MessagePack and CBOR the body is the shared
+// key/value pairs, and each copy starts with a map header counting both sets, then the private pairs.
+void Server::broadcastWithPrivate(const GameRoom& room, const json& shared,
+                                  const std::function<json(size_t)>& privateFields,
+                                  const std::function<std::string(size_t)>& compactBody)
 {
-    // Accept connections on both TCP and WebSocket ports
-    std::thread tcp_thread([this]() {
-        while (true) {
-            sockaddr_in clientAddress;
-            socklen_t clientLen = sizeof(clientAddress);
-            int client_fd = accept(server_fd, (struct sockaddr *)&clientAddress, &clientLen);
-            
-            if (client_fd < 0) {
-                cerr << "TCP Accept failed" << endl;
-                continue;
-            }
+    std::shared_ptr<const std::string> bodies[NUM_ENCODINGS];
+    DeflatedBody deflated[NUM_ENCODINGS][DEFLATE_MAX_WINDOW_BITS + 1];
 
-            cout << "New TCP client connected: fd=" << client_fd << endl;
-            {
-                std::lock_guard<std::mutex> lock(server_mutex);
-                clientTypes[client_fd] = ClientType::TCP;
-            }
-            std::thread(&Server::handleClient, this, client_fd, ClientType::TCP).detach();
-        }
-    });
-    
-    // WebSocket acceptor (main thread)
-    while (true) {
-        sockaddr_in clientAddress;
-        socklen_t clientLen = sizeof(clientAddress);
-        int client_fd = accept(ws_server_fd, (struct sockaddr *)&clientAddress, &clientLen);
-        
-        if (client_fd < 0) {
-            cerr << "WebSocket Accept failed" << endl;
+    for (size_t i = 0; i < room.players.size(); i++) {
+        const Player& player = room.players[i];
+        int encoding = static_cast<int>(player.encoding);
+        bool isJson = player.encoding == WireEncoding::JSON || player.encoding == WireEncoding::COMPACT;
+
+        // A compact message is a few dozen bytes, so it is simply built whole for each seat
+        if (player.encoding == WireEncoding::COMPACT && compactBody) {
+            std::string message = compactBody(i);
+            std::string bytes = tcpHeader(message.size());
+            bytes += message;
+            reactor->send(player.server_fd, bytes);
             continue;
         }
 
-        cout << "New WebSocket client connecting: fd=" << client_fd << endl;
-        
-        // Perform WebSocket handshake
-        if (!performWebSocketHandshake(client_fd)) {
-            cerr << "WebSocket handshake failed" << endl;
-            close(client_fd);
-            continue;
+        std::shared_ptr<const std::string>& body = bodies[encoding];
+        if (!body) {
+            std::string encoded = encodeMessage(shared, player.encoding);
+            size_t skip = isJson ? 1 : mapHeaderLength(encoded, player.encoding);
+            body = std::make_shared<const std::string>(encoded, skip);
         }
-        
-        cout << "WebSocket handshake successful: fd=" << client_fd << endl;
-        {
-            std::lock_guard<std::mutex> lock(server_mutex);
-            clientTypes[client_fd] = ClientType::WEBSOCKET;
+
+        json privateJson = privateFields(i);
+        std::string fields = encodeMessage(privateJson, player.encoding);
+        if (isJson) {
+            fields.pop_back();
+            if (fields.size() > 1 && !shared.empty()) {
+                fields.push_back(',');
+            }
+        } else {
+            fields = mapHeader(shared.size() + privateJson.size(), player.encoding)
+                   + fields.substr(mapHeaderLength(fields, player.encoding));
+        }
+
+        // Deflate clients: the private pairs are compressed on their own and followed by the
+        // shared body, compressed once. Both are standalone, so the blocks simply run on.
+        if (player.deflate && fields.size() + body->size() >= DEFLATE_MIN_BYTES) {
+            DeflatedBody& compressed = deflatedBody(deflated[encoding], player, *body);
+            std::string prefix;
+            deflateStandalone(fields.data(), fields.size(), player.deflate->level,
+                              player.deflate->params.serverWindowBits, prefix, false);
+            std::string head = frameHeader(player.clientType, player.encoding,
+                                           prefix.size() + compressed.body->size(), true);
+            head += prefix;
+            std::lock_guard<std::mutex> lock(player.deflate->lock);
+            player.deflate->queuedStandalone();
+            reactor->send(player.server_fd, OutboundMessage{std::move(head), compressed.body});
+            continue;
         }
-        std::thread(&Server::handleClient, this, client_fd, ClientType::WEBSOCKET).detach();
+
+        std::string head = frameHeader(player.clientType, player.encoding, fields.size() + body->size());
+        head += fields;
+        reactor->send(player.server_fd, OutboundMessage{std::move(head), body});
     }
 }
 
-void Server::handleClient(int client_fd, ClientType /*clientType*/)
+void Server::run()
+{
+    // Both ports are served from the reactor; WebSocket connections start with their HTTP upgrade
+    reactor->listen(server_fd, ClientType::TCP);
+    reactor->listen(ws_server_fd, ClientType::WEBSOCKET);
+
+    LOG_INFO(SERVER, "Serving clients on " << reactor->getNumThreads() << " " << reactor->name() << " reactor threads");
+    reactor->run();
+}
+
+void Server::onOpen(Connection& conn)
 {
-    std::string client_username = "";
-    
+    if (conn.type == ClientType::TCP) {
+        LOG_INFO(NET, "New TCP client connected: fd=" << conn.fd);
+    } else {
+        LOG_DEBUG(NET, "New WebSocket client connecting: fd=" << conn.fd);
+    }
+}
+
+void Server::onData(Connection& conn)
+{
+    size_t offset = 0;
     try
     {
-        while (true)
+        Request request;
+        while (!conn.closing && nextMessage(conn, offset, request))
         {
-            json request = receiveMessage(client_fd);
-
-            cout << "\n=== Received Message from fd=" << client_fd << " ===" << endl;
-            cout << request.dump(2) << endl;
-            
-            MessageType msgType = getMessageType(request["type"]);
-
-            switch (msgType)
-            {
-            case MessageType::REGISTER:
-                handleRegister(request, client_fd, client_username);
-                break;
-            case MessageType::LIST_GAMES:
-                handleListGames(request, client_fd);
-                break;
-            case MessageType::CREATE_GAME:
-                handleCreateGame(request, client_fd);
-                break;
-            case MessageType::JOIN_GAME:
-                handleJoinGame(request, client_fd);
-                break;
-            case MessageType::EXIT_GAME:
-                handleExitGame(request, client_fd);
-                break;
-            case MessageType::UNREGISTER:
-                handleUnregister(request, client_fd, client_username);
-                break;
-            case MessageType::START_GAME:
-                handleStartGame(request, client_fd);
-                break;
-            case MessageType::PLAY_TURN:
-                handleAction(request, client_fd);
-                break;
-            default:
-                cout << "Unknown message type received." << endl;
-                json response = {
-                    {"type", "ERROR"},
-                    {"error", "Unknown message type"}
-                };
-                sendMessage(client_fd, response);
-                break;
-            }
+            dispatch(conn, request);
         }
     }
     catch (const std::exception &e)
     {
-        cerr << "Client handling error (fd=" << client_fd << "): " << e.what() << endl;
-        
-        // Cleanup on disconnect
-        std::lock_guard<std::mutex> lock(server_mutex);
-        
-        if (!client_username.empty())
+        LOG_WARN(NET, "Client handling error (fd=" << conn.fd << "): " << e.what());
+        reactor->close(conn.fd);
+    }
+    conn.input.consume(offset);
+}
+
+void Server::dispatch(Connection& conn, const Request& request)
+{
+    int client_fd = conn.fd;
+    MessageType msgType = request.type.value;
+
+    LOG_DEBUG(MSG, "Received " << messageName(msgType) << " from fd=" << client_fd);
+
+    switch (msgType)
+    {
+    case MessageType::REGISTER:
+        handleRegister(request, client_fd, conn.username);
+        break;
+    case MessageType::LIST_GAMES:
+        handleListGames(request, client_fd);
+        break;
+    case MessageType::CREATE_GAME:
+        handleCreateGame(request, client_fd);
+        break;
+    case MessageType::JOIN_GAME:
+        handleJoinGame(request, client_fd);
+        break;
+    case MessageType::EXIT_GAME:
+        handleExitGame(request, client_fd);
+        break;
+    case MessageType::UNREGISTER:
+        handleUnregister(request, client_fd, conn.username);
+        break;
+    case MessageType::START_GAME:
+        handleStartGame(request, client_fd);
+        break;
+    case MessageType::PLAY_TURN:
+        handleAction(request, client_fd);
+        break;
+    case MessageType::RESYNC:
+        handleResync(request, client_fd);
+        break;
+    default:
+        LOG_DEBUG(MSG, "Unknown message type received.");
+        json response = {
+            {"type", "ERROR"},
+            {"error", "Unknown message type"}
+        };
+        sendMessage(client_fd, response);
+        break;
+    }
+}
+
+// Unconsumed input never legally reaches these: a handshake is answered (or refused) once its
+// headers end, and anything longer than one message is consumed as soon as it is complete
+size_t Server::inputLimit(const Connection& conn) const
+{
+    if (conn.type == ClientType::WEBSOCKET) {
+        // The headers plus the blank line that ends them
+        return conn.upgrading ? MAX_HANDSHAKE_BYTES + 4 : MAX_WS_MESSAGE_BYTES + MAX_WS_FRAMING_BYTES;
+    }
+    return sizeof(uint32_t) + MAX_TCP_MESSAGE_BYTES;
+}
+
+void Server::onClose(Connection& conn)
+{
+    const std::string& client_username = conn.username;
+    LOG_INFO(NET, "Client disconnected: fd=" << conn.fd);
+
+    // Cleanup on disconnect
+    if (!client_username.empty())
+    {
+        int game_id = -1;
         {
-            // Remove from game if in one
+            std::lock_guard<std::mutex> lock(registryLock);
             auto playerGameIt = playerToGameID.find(client_username);
             if (playerGameIt != playerToGameID.end())
             {
-                int game_id = playerGameIt->second;
-                auto roomIt = gameRooms.find(game_id);
-                
-                if (roomIt != gameRooms.end())
+                game_id = playerGameIt->second;
+            }
+        }
+
+        // Remove from game if in one
+        if (game_id >= 0)
+        {
+            {
+                std::unique_lock<std::mutex> roomLock;
+                std::shared_ptr<GameRoom> room = lockRoom(game_id, roomLock);
+                if (room)
                 {
-                    GameRoom& room = roomIt->second;
-                    auto idIt = room.playerIndex.find(client_username);
-                    
-                    if (idIt != room.playerIndex.end())
-                    {
-                        int playerIdx = idIt->second;
-                        
-                        if (playerIdx < (int)room.players.size() - 1) {
-                            std::string movedPlayerName = room.players.back().username;
-                            room.players[playerIdx] = room.players.back();
-                            room.playerIndex[movedPlayerName] = playerIdx;
-                        }
-                        room.players.pop_back();
-                        room.playerIndex.erase(client_username);
-                    }
-                    
-                    if (room.players.empty()) {
-                        freeGameID.push_back(game_id);
-                        gameRooms.erase(game_id);
-                    }
+                    removePlayer(*room, client_username);
                 }
-                
-                playerToGameID.erase(client_username);
             }
-            
-            // Unregister player
+            releaseRoomIfEmpty(game_id);
+        }
+
+        // Unregister player
+        {
+            std::lock_guard<std::mutex> lock(registryLock);
+            playerToGameID.erase(client_username);
             registeredPlayers.erase(client_username);
-            cout << "Cleaned up disconnected client: " << client_username << endl;
         }
-        
-        clientTypes.erase(client_fd);
-        close(client_fd);
+        LOG_INFO(NET, "Cleaned up disconnected client: " << client_username);
+    }
+}
+
+// Look up a room and take its lock. Returns nullptr (with nothing locked) if there is no such
+// room. A room only leaves gameRooms while its lock is held, so it stays alive as long as we hold it.
+std::shared_ptr<GameRoom> Server::lockRoom(int game_id, std::unique_lock<std::mutex>& lock)
+{
+    std::shared_ptr<GameRoom> room;
+    {
+        std::shared_lock<std::shared_mutex> roomsGuard(roomsLock);
+        auto it = gameRooms.find(game_id);
+        if (it == gameRooms.end()) {
+            return nullptr;
+        }
+        room = it->second;
+    }
+    lock = std::unique_lock<std::mutex>(room->lock);
+    if (room->closed) {
+        lock.unlock();
+        return nullptr;
+    }
+    return room;
+}
+
+// Caller holds room.lock. The last player swaps into the freed seat.
+bool Server::removePlayer(GameRoom& room, const string& username)
+{
+    auto idIt = room.playerIndex.find(username);
+    if (idIt == room.playerIndex.end()) {
+        return false;
+    }
+
+    int playerIdx = idIt->second;
+    if (playerIdx < (int)room.players.size() - 1) {
+        std::string movedPlayerName = room.players.back().username;
+        room.players[playerIdx] = room.players.back();
+        room.playerIndex[movedPlayerName] = playerIdx;
+    }
+    room.players.pop_back();
+    room.playerIndex.erase(username);
+    // New seating, new seq; lastView keeps the old seats, so the next broadcast is a snapshot
+    room.stateSeq++;
+    return true;
+}
+
+// Called without the room's lock held (lock order). Someone may have joined in the meantime,
+// so emptiness is checked again under both locks.
+void Server::releaseRoomIfEmpty(int game_id)
+{
+    std::unique_lock<std::shared_mutex> roomsGuard(roomsLock);
+    auto it = gameRooms.find(game_id);
+    if (it == gameRooms.end()) {
+        return;
+    }
+    std::shared_ptr<GameRoom> room = it->second;
+    std::lock_guard<std::mutex> roomLock(room->lock);
+    if (room->players.empty()) {
+        room->closed = true;
+        gameRooms.erase(it);
+        freeGameID.push_back(game_id);
     }
 }
 
-void Server::handleRegister(const json &request, int client_fd, std::string &client_username)
+void Server::handleRegister(const Request &request, int client_fd, std::string &client_username)
 {
-    std::lock_guard<std::mutex> lock(server_mutex);
-    
-    string username = request["name"];
+    const string& username = request.name.required();
     
     // NEW: Check if token exists (optional for now)
     string token = "";
-    if (request.contains("token")) {
-        token = request["token"];
-        cout << "Received token: " << token << endl;
+    if (request.token.present) {
+        token = request.token.value;
+        LOG_DEBUG(MSG, "Received token: " << token);
         // TODO: Verify token with auth server later
     }
 
@@ -547,6 +984,7 @@ void Server::handleRegister(const json &request, int client_fd, std::string &cli
         return; 
     }
     
+    std::lock_guard<std::mutex> lock(registryLock);
     if (registeredPlayers.find(username) != registeredPlayers.end())
     {
         json response = {
@@ -567,44 +1005,56 @@ void Server::handleRegister(const json &request, int client_fd, std::string &cli
 
     sendMessage(client_fd, response);
 }
-void Server::handleListGames(const json& /*request*/, int client_fd)
+void Server::handleListGames(const Request& /*request*/, int client_fd)
 {
-    std::lock_guard<std::mutex> lock(server_mutex);
-    
     json response = {
         {"type", "LIST_GAMES_RESPONSE"},
         {"status", "SUCCESS"},
         {"games", json::array()}
     };
 
-    if(gameRooms.empty())
+    // Snapshot the room list, then read each room under its own lock
+    std::vector<std::shared_ptr<GameRoom>> rooms;
     {
-        response["message"] = "No active game rooms available.";
-        cout << "LIST_GAMES_RESPONSE (empty): " << response.dump() << endl;
-        sendMessage(client_fd, response);
-        return;
+        std::shared_lock<std::shared_mutex> roomsGuard(roomsLock);
+        rooms.reserve(gameRooms.size());
+        for (const auto &game : gameRooms)
+        {
+            rooms.push_back(game.second);
+        }
     }
 
-    for (const auto &game : gameRooms)
+    for (const auto &room : rooms)
     {
+        std::lock_guard<std::mutex> roomLock(room->lock);
+        if (room->closed)
+        {
+            continue;
+        }
         response["games"].push_back({
-            {"game_id", game.second.gameID},
-            {"small_blind", game.second.smallBlind},
-            {"big_blind", game.second.bigBlind},
-            {"player_count", game.second.players.size()},
-            {"game_stage", game.second.gameStages}
+            {"game_id", room->gameID},
+            {"small_blind", room->smallBlind},
+            {"big_blind", room->bigBlind},
+            {"player_count", room->players.size()},
+            {"game_stage", room->gameStages}
         });
     }
+
+    if(response["games"].empty())
+    {
+        response["message"] = "No active game rooms available.";
+        LOG_DEBUG(MSG, "LIST_GAMES_RESPONSE (empty): " << response.dump());
+        sendMessage(client_fd, response);
+        return;
+    }
     
-    cout << "LIST_GAMES_RESPONSE: " << response.dump() << endl;
+    LOG_DEBUG(MSG, "LIST_GAMES_RESPONSE: " << response.dump());
     sendMessage(client_fd, response);
 }
 
-void Server::handleCreateGame(const json &request, int client_fd)
+void Server::handleCreateGame(const Request &request, int client_fd)
 {
-    std::lock_guard<std::mutex> lock(server_mutex);
-    
-    if (!request.contains("small_blind") || !request.contains("big_blind"))
+    if (!request.smallBlind.present || !request.bigBlind.present)
     {
         json response = {
             {"type", "CREATE_GAME_RESPONSE"},
@@ -615,8 +1065,8 @@ void Server::handleCreateGame(const json &request, int client_fd)
         return;
     }
     
-    int smallBlind = request["small_blind"];
-    int bigBlind = request["big_blind"];
+    int smallBlind = request.smallBlind.value;
+    int bigBlind = request.bigBlind.value;
     
     if (smallBlind <= 0 || bigBlind <= 0)
     {
@@ -640,48 +1090,67 @@ void Server::handleCreateGame(const json &request, int client_fd)
         return;
     }
 
-    int game_id;
-    if (!freeGameID.empty()) {
-        game_id = freeGameID.back();
-        freeGameID.pop_back();
-    } else {
-        game_id = nextGameID++;
+    // Optional shuffle engine: "secure" (default) or "fast" for simulations and bot tables
+    RngKind rngKind = RngKind::SECURE;
+    if (request.rng.present && !parseRngKind(request.rng.value, rngKind))
+    {
+        json response = {
+            {"type", "CREATE_GAME_RESPONSE"},
+            {"status", "ERROR"},
+            {"error", "rng must be \"fast\" or \"secure\""}
+        };
+        sendMessage(client_fd, response);
+        return;
     }
 
-    GameRoom newRoom;
-    newRoom.gameID = game_id;
-    newRoom.smallBlind = smallBlind;
-    newRoom.bigBlind = bigBlind;
-    newRoom.currentPlayerIndex = 0;
-    newRoom.Pot = 0;
-    newRoom.currentBet = 0;
-    newRoom.buttonPosition = 0;
-    newRoom.gameStages = "WAITING";
-    newRoom.lastRaiser = -1;
-    newRoom.poker = std::make_unique<Poker>();
-    
-    gameRooms[game_id] = std::move(newRoom);
+    auto newRoom = std::make_shared<GameRoom>();
+    newRoom->smallBlind = smallBlind;
+    newRoom->bigBlind = bigBlind;
+    newRoom->currentPlayerIndex = 0;
+    newRoom->Pot = 0;
+    newRoom->currentBet = 0;
+    newRoom->buttonPosition = 0;
+    newRoom->gameStages = "WAITING";
+    newRoom->lastRaiser = -1;
+    newRoom->poker = std::make_unique<Poker>(makeDeckRng(rngKind));
+
+    int game_id;
+    {
+        std::unique_lock<std::shared_mutex> roomsGuard(roomsLock);
+        if (!freeGameID.empty()) {
+            game_id = freeGameID.back();
+            freeGameID.pop_back();
+        } else {
+            game_id = nextGameID++;
+        }
+        newRoom->gameID = game_id;
+        gameRooms[game_id] = std::move(newRoom);
+    }
     
     json response = {
         {"type", "CREATE_GAME_RESPONSE"},
         {"status", "SUCCESS"},
         {"game_id", game_id},
+        {"rng", rngKindName(rngKind)},
         {"message", "Game created successfully"}
     };
     
     sendMessage(client_fd, response);
-    cout << "Game created with ID: " << game_id << endl;
+    LOG_INFO(GAME, "Game created with ID: " << game_id << " (" << rngKindName(rngKind) << " rng)");
 }
 
-void Server::handleJoinGame(const json &request, int client_fd) 
+void Server::handleJoinGame(const Request &request, int client_fd) 
 {
-    std::lock_guard<std::mutex> lock(server_mutex);
-    
-    int game_id = request["game_id"];
-    string username = request["username"];
+    int game_id = request.gameId.required();
+    const string& username = request.username.required();
     
     json response = {{"type", "JOIN_GAME_RESPONSE"}};
 
+    // Seating touches the room and the registry together, so both locks are held throughout
+    std::unique_lock<std::mutex> roomLock;
+    std::shared_ptr<GameRoom> room = lockRoom(game_id, roomLock);
+    std::lock_guard<std::mutex> lock(registryLock);
+
     if (registeredPlayers.find(username) == registeredPlayers.end()) {
         response["status"] = "ERROR";
         response["error"] = "Invalid Player ID";
@@ -696,30 +1165,28 @@ void Server::handleJoinGame(const json &request, int client_fd)
         return;
     }
     
-    auto it = gameRooms.find(game_id);
-    
-    if (it == gameRooms.end()) {
+    if (!room) {
         response["status"] = "ERROR";
         response["error"] = "Game room not found";
         sendMessage(client_fd, response);
         return;
     }
 
-    if (it->second.players.size() >= MAX_PLAYERS) {
+    if (room->players.size() >= MAX_PLAYERS) {
         response["status"] = "ERROR";
         response["error"] = "Game room is full";
         sendMessage(client_fd, response);
         return;
     }
     
-    if (it->second.gameStages != "WAITING") {
+    if (room->gameStages != "WAITING") {
         response["status"] = "ERROR";
         response["error"] = "Game already in progress";
         sendMessage(client_fd, response);
         return;
     }
     
-    if(!request.contains("starting_stack") || request["starting_stack"] <= 0) {
+    if(!request.startingStack.present || request.startingStack.value <= 0) {
         response["status"] = "ERROR";
         response["error"] = "starting_stack must be positive";
         sendMessage(client_fd, response);
@@ -730,99 +1197,89 @@ void Server::handleJoinGame(const json &request, int client_fd)
     newPlayer.username = username;
     newPlayer.server_fd = client_fd;
     newPlayer.gameRoomID = game_id;
-    newPlayer.chips = (int)request["starting_stack"];
+    newPlayer.chips = request.startingStack.value;
     newPlayer.hasHand = true;
     newPlayer.currentBet = 0;
     newPlayer.isActive = true;
+    newPlayer.deltaUpdates = request.stateUpdates.valueOr("full") == "delta";
     
-    auto typeIt = clientTypes.find(client_fd);
-    newPlayer.clientType = (typeIt != clientTypes.end()) ? typeIt->second : ClientType::TCP;
+    std::shared_ptr<Connection> conn = reactor->find(client_fd);
+    newPlayer.clientType = conn ? conn->type : ClientType::TCP;
+    newPlayer.encoding = conn ? conn->encoding : WireEncoding::JSON;
+    newPlayer.deflate = conn ? conn->deflate : nullptr;
+    // Compact state messages are already small, so compact clients always get whole ones
+    if (newPlayer.encoding == WireEncoding::COMPACT) {
+        newPlayer.deltaUpdates = false;
+    }
 
-    int playerIdx = it->second.players.size();
-    it->second.players.push_back(newPlayer);
-    it->second.playerIndex[username] = playerIdx; 
+    int playerIdx = room->players.size();
+    room->players.push_back(newPlayer);
+    room->playerIndex[username] = playerIdx; 
+    room->stateSeq++;   // As in removePlayer
     
     playerToGameID[username] = game_id; 
     
     response["status"] = "SUCCESS";
     response["message"] = "Joined game successfully";
-    response["player_count"] = it->second.players.size();
+    response["player_count"] = room->players.size();
 
     sendMessage(client_fd, response);
-    cout << username << " joined game " << game_id << endl;
+    if (newPlayer.deltaUpdates) {
+        sendMessage(client_fd, stateSnapshot(*room, "GAME_STATE_SNAPSHOT"));
+    }
+    LOG_INFO(GAME, username << " joined game " << game_id);
 }
 
-void Server::handleExitGame(const json &request, int client_fd) 
+void Server::handleExitGame(const Request &request, int client_fd) 
 {
-    std::lock_guard<std::mutex> lock(server_mutex);
-    
-    string username = request["username"];
+    const string& username = request.username.required();
     
     json response = {{"type", "EXIT_GAME_RESPONSE"}};
     
-    auto playerGameIt = playerToGameID.find(username);
-    
-    if (playerGameIt == playerToGameID.end()) {
-        response["status"] = "ERROR";
-        response["error"] = "Player not in any game";
-        sendMessage(client_fd, response);
-        return;
-    }
-    
-    int game_id = playerGameIt->second;
-    auto roomIt = gameRooms.find(game_id); 
-    
-    if (roomIt == gameRooms.end()) {
-        playerToGameID.erase(username);
-        response["status"] = "ERROR";
-        response["error"] = "Game room not found";
-        sendMessage(client_fd, response);
-        return;
+    int game_id;
+    {
+        std::lock_guard<std::mutex> lock(registryLock);
+        auto playerGameIt = playerToGameID.find(username);
+        
+        if (playerGameIt == playerToGameID.end()) {
+            response["status"] = "ERROR";
+            response["error"] = "Player not in any game";
+            sendMessage(client_fd, response);
+            return;
+        }
+        game_id = playerGameIt->second;
     }
     
-    GameRoom& room = roomIt->second;
-    auto idIt = room.playerIndex.find(username);
+    {
+        std::unique_lock<std::mutex> roomLock;
+        std::shared_ptr<GameRoom> room = lockRoom(game_id, roomLock);
+        bool removed = room && removePlayer(*room, username);
 
-    if(idIt == room.playerIndex.end()) {
+        std::lock_guard<std::mutex> lock(registryLock);
         playerToGameID.erase(username);
-        response["status"] = "ERROR";
-        response["error"] = "Player not found in game room";
-        sendMessage(client_fd, response);
-        return;
-    }
-    
-    int playerIdx = idIt->second;
-    
-    if (playerIdx < (int)room.players.size() - 1) {
-        std::string movedPlayerName = room.players.back().username;
-        room.players[playerIdx] = room.players.back();
-        room.playerIndex[movedPlayerName] = playerIdx;
-    }
-    room.players.pop_back();
-    
-    room.playerIndex.erase(username);
-    playerToGameID.erase(username); 
-    
-    if (room.players.empty()) {
-        freeGameID.push_back(game_id);
-        gameRooms.erase(game_id);
+        if (!removed) {
+            response["status"] = "ERROR";
+            response["error"] = room ? "Player not found in game room" : "Game room not found";
+            sendMessage(client_fd, response);
+            return;
+        }
     }
+    releaseRoomIfEmpty(game_id);
     
     response["status"] = "SUCCESS";
     response["message"] = "Exited game successfully";
     
     sendMessage(client_fd, response);
-    cout << username << " exited game " << game_id << endl;
+    LOG_INFO(GAME, username << " exited game " << game_id);
 }
 
-void Server::handleUnregister(const json &request, int client_fd, std::string &client_username)
+void Server::handleUnregister(const Request &request, int client_fd, std::string &client_username)
 {
-    std::lock_guard<std::mutex> lock(server_mutex);
-    
-    string username = request["username"];
+    const string& username = request.username.required();
     
     json response = {{"type", "UNREGISTER_RESPONSE"}};
     
+    std::lock_guard<std::mutex> lock(registryLock);
     auto it = registeredPlayers.find(username);
     
     if (it == registeredPlayers.end()) {
@@ -846,26 +1303,25 @@ void Server::handleUnregister(const json &request, int client_fd, std::string &c
     response["message"] = "Unregistered successfully";
     
     sendMessage(client_fd, response);
-    cout << username << " unregistered successfully" << endl;
+    LOG_INFO(GAME, username << " unregistered successfully");
 }
 
-void Server::handleStartGame(const json& request, int client_fd) {
-    std::lock_guard<std::mutex> lock(server_mutex);
-    
-    int game_id = request["game_id"];
-    string username = request["username"];
+void Server::handleStartGame(const Request& request, int client_fd) {
+    int game_id = request.gameId.required();
+    request.username.required();    // Not checked against the room, but still part of the message
     
     json response = {{"type", "START_GAME_RESPONSE"}};
     
-    auto roomIt = gameRooms.find(game_id);
-    if (roomIt == gameRooms.end()) {
+    std::unique_lock<std::mutex> roomLock;
+    std::shared_ptr<GameRoom> roomPtr = lockRoom(game_id, roomLock);
+    if (!roomPtr) {
         response["status"] = "ERROR";
         response["error"] = "Game not found";
         sendMessage(client_fd, response);
         return;
     }
     
-    GameRoom& room = roomIt->second;
+    GameRoom& room = *roomPtr;
     
     if (room.players.size() < 2) {
         response["status"] = "ERROR";
@@ -891,7 +1347,7 @@ void Server::handleStartGame(const json& request, int client_fd) {
     
     // Deal hole cards to each player
     for (auto& player : room.players) {
-        player.holeCards = room.poker->dealCards(2);
+        player.holeCards = room.poker->dealHoleCards();
         player.hasHand = true;
         player.isActive = true;
         player.currentBet = 0;
@@ -934,45 +1390,71 @@ void Server::handleStartGame(const json& request, int client_fd) {
     
     sendMessage(client_fd, response);
     
-    // Notify all players about game start and their hole cards
-    for (size_t i = 0; i < room.players.size(); i++) {
-        json notify = {
-            {"type", "GAME_STARTED"},
-            {"game_id", game_id},
+    // Notify all players about game start; only the seat and hole cards differ between them.
+    // It is a full snapshot, so it also restarts the delta baseline.
+    room.stateSeq++;
+    room.lastView = captureView(room);
+    room.lastAction = nullptr;
+    json notify = {
+        {"type", "GAME_STARTED"},
+        {"game_id", game_id},
+        {"seq", room.stateSeq},
+        {"stage", room.gameStages},
+        {"community_cards", json::array()},
+        {"button_position", room.buttonPosition},
+        {"small_blind_position", sbIdx},
+        {"big_blind_position", bbIdx},
+        {"pot", room.Pot},
+        {"current_bet", room.currentBet},
+        {"current_player", room.currentPlayerIndex},
+        {"players", json::array()}
+    };
+    
+    // Add all player info
+    for (const auto& p : room.players) {
+        notify["players"].push_back({
+            {"username", p.username},
+            {"chips", p.chips},
+            {"current_bet", p.currentBet},
+            {"is_active", p.isActive},
+            {"has_hand", p.hasHand}
+        });
+    }
+    
+    broadcastWithPrivate(room, notify, [&](size_t i) {
+        json privateFields = {
             {"your_position", i},
-            {"button_position", room.buttonPosition},
-            {"small_blind_position", sbIdx},
-            {"big_blind_position", bbIdx},
-            {"pot", room.Pot},
-            {"current_bet", room.currentBet},
-            {"current_player", room.currentPlayerIndex},
-            {"hole_cards", json::array()},
-            {"players", json::array()}
+            {"hole_cards", json::array()}
         };
-        
-        // Add hole cards for this player
         for (const auto& card : room.players[i].holeCards) {
-            notify["hole_cards"].push_back({
+            privateFields["hole_cards"].push_back({
                 {"rank", room.poker->rankToString(card.rank)},
                 {"suit", room.poker->suitToString(card.suit)}
             });
         }
-        
-        // Add all player info
+        return privateFields;
+    }, [&](size_t i) {
+        compact::GameStarted started;
+        started.gameId = game_id;
+        started.seq = room.stateSeq;
+        started.yourSeat = static_cast<uint8_t>(i);
+        for (const auto& card : room.players[i].holeCards) {
+            started.holeCards.push(compact::cardCode(card));
+        }
+        started.buttonSeat = static_cast<uint8_t>(room.buttonPosition);
+        started.smallBlindSeat = static_cast<uint8_t>(sbIdx);
+        started.bigBlindSeat = static_cast<uint8_t>(bbIdx);
+        started.pot = room.Pot;
+        started.currentBet = room.currentBet;
+        started.currentSeat = static_cast<uint8_t>(room.currentPlayerIndex);
         for (const auto& p : room.players) {
-            notify["players"].push_back({
-                {"username", p.username},
-                {"chips", p.chips},
-                {"current_bet", p.currentBet},
-                {"is_active", p.isActive},
-                {"has_hand", p.hasHand}
-            });
+            started.seats.push({p.username, static_cast<uint64_t>(p.chips),
+                                static_cast<uint64_t>(p.currentBet), seatFlags(p)});
         }
-        
-        sendMessage(room.players[i].server_fd, notify);
-    }
+        return compact::encode(started);
+    });
     
-    cout << "Game " << game_id << " started with " << room.players.size() << " players" << endl;
+    LOG_INFO(GAME, "Game " << game_id << " started with " << room.players.size() << " players");
 }
 
 bool Server::isBettingRoundComplete(GameRoom& room) {
@@ -1038,7 +1520,7 @@ void Server::advanceGameStage(GameRoom& room) {
 
 void Server::handleShowdown(GameRoom& room) {
     // Collect all active players' hands
-    std::vector<std::vector<Card>> activeHands;
+    std::vector<HoleCards> activeHands;
     std::vector<int> activePlayerIndices;
     
     for (size_t i = 0; i < room.players.size(); i++) {
@@ -1114,7 +1596,7 @@ void Server::handleShowdown(GameRoom& room) {
     }
     
     // Add community cards
-    for (const auto& card : room.poker->getCommunityCards()) {
+    for (const auto& card : room.poker->getBoard()) {
         showdownMsg["community_cards"].push_back({
             {"rank", room.poker->rankToString(card.rank)},
             {"suit", room.poker->suitToString(card.suit)}
@@ -1131,9 +1613,36 @@ void Server::handleShowdown(GameRoom& room) {
     }
     
     // Send to all players
-    for (const auto& player : room.players) {
-        sendMessage(player.server_fd, showdownMsg);
-    }
+    broadcast(room, showdownMsg, 0, nullptr, [&]() {
+        compact::Showdown showdown;
+        showdown.gameId = room.gameID;
+        showdown.pot = room.Pot;
+        for (const auto& card : room.poker->getBoard()) {
+            showdown.board.push(compact::cardCode(card));
+        }
+        for (size_t i = 0; i < actualWinners.size(); i++) {
+            const Player& winner = room.players[actualWinners[i]];
+            Poker::HandValue handVal = room.poker->evaluateHandDetailed(winner.holeCards);
+            showdown.winners.push({static_cast<uint8_t>(actualWinners[i]),
+                                   static_cast<uint8_t>(handVal.rank),
+                                   static_cast<uint64_t>(potShare + (i == 0 ? remainder : 0)),
+                                   static_cast<uint64_t>(winner.chips)});
+        }
+        for (size_t i = 0; i < room.players.size(); i++) {
+            const Player& p = room.players[i];
+            if (p.hasHand) {
+                compact::ShownHand hand;
+                hand.seat = static_cast<uint8_t>(i);
+                hand.handRank = static_cast<uint8_t>(room.poker->evaluateHandDetailed(p.holeCards).rank);
+                for (const auto& card : p.holeCards) {
+                    hand.cards.push(compact::cardCode(card));
+                }
+                showdown.hands.push(hand);
+            }
+            showdown.chips.push(static_cast<uint64_t>(p.chips));
+        }
+        return compact::encode(showdown);
+    });
     
     // Reset for next hand
     room.gameStages = "WAITING";
@@ -1142,24 +1651,55 @@ void Server::handleShowdown(GameRoom& room) {
     room.buttonPosition = (room.buttonPosition + 1) % room.players.size();
     room.hasActedThisRound.clear();
     room.lastRaiser = -1;
+    newStateVersion(room);
     
-    cout << "Showdown complete for game " << room.gameID << endl;
+    LOG_INFO(GAME, "Showdown complete for game " << room.gameID);
 }
 
+// Full-state clients get the whole table (coalesced if they lag); delta clients get what changed
 void Server::broadcastGameState(GameRoom& room) {
-    std::vector<Card> communityCards = room.poker->getCommunityCards();
+    bool anyFull = false;
+    bool anyDelta = false;
+    for (const auto& player : room.players) {
+        if (player.deltaUpdates) {
+            anyDelta = true;
+        } else {
+            anyFull = true;
+        }
+    }
+
+    room.stateSeq++;
+    TableView view = captureView(room);
+    if (anyFull) {
+        broadcast(room, stateSnapshot(room, "GAME_STATE_UPDATE"), stateUpdateKey(room.gameID),
+                  [](const Player& p) { return !p.deltaUpdates; },
+                  [&]() { return compactState(room); });
+    }
+    if (anyDelta) {
+        // Deltas build on each other, so unlike full updates they are never coalesced
+        broadcast(room, stateDelta(room, view), 0, [](const Player& p) { return p.deltaUpdates; });
+    }
+    room.lastView = std::move(view);
+    room.lastAction = nullptr;
+}
+
+json Server::stateSnapshot(const GameRoom& room, const char* type) {
+    const Board& communityCards = room.poker->getBoard();
     
     json stateMsg = {
-        {"type", "GAME_STATE_UPDATE"},
+        {"type", type},
         {"game_id", room.gameID},
+        {"seq", room.stateSeq},
         {"stage", room.gameStages},
         {"pot", room.Pot},
         {"current_bet", room.currentBet},
         {"current_player", room.currentPlayerIndex},
-        {"current_player_name", room.players[room.currentPlayerIndex].username},
         {"community_cards", json::array()},
         {"players", json::array()}
     };
+    if (room.currentPlayerIndex < (int)room.players.size()) {
+        stateMsg["current_player_name"] = room.players[room.currentPlayerIndex].username;
+    }
     
     // Add community cards
     for (const auto& card : communityCards) {
@@ -1179,132 +1719,354 @@ void Server::broadcastGameState(GameRoom& room) {
             {"has_hand", player.hasHand}
         });
     }
-    
-    // Send to all players
+    return stateMsg;
+}
+
+// Changed fields since room.lastView, as absolute values, so applying a delta on top of a newer
+// snapshot is harmless. Seats coming or going changes indices, so that sends a snapshot instead.
+json Server::stateDelta(const GameRoom& room, const TableView& view) {
+    const TableView& last = room.lastView;
+    bool sameSeats = last.seats.size() == view.seats.size();
+    for (size_t i = 0; sameSeats && i < view.seats.size(); i++) {
+        sameSeats = last.seats[i].username == view.seats[i].username;
+    }
+    if (!sameSeats) {
+        return stateSnapshot(room, "GAME_STATE_SNAPSHOT");
+    }
+
+    json delta = {
+        {"type", "GAME_STATE_DELTA"},
+        {"game_id", room.gameID},
+        {"seq", room.stateSeq}
+    };
+    if (!room.lastAction.is_null()) {
+        delta["action"] = room.lastAction;
+    }
+    if (view.stage != last.stage) {
+        delta["stage"] = view.stage;
+    }
+    if (view.pot != last.pot) {
+        delta["pot"] = view.pot;
+    }
+    if (view.currentBet != last.currentBet) {
+        delta["current_bet"] = view.currentBet;
+    }
+    if (view.currentPlayer != last.currentPlayer) {
+        delta["current_player"] = view.currentPlayer;
+    }
+
+    // New board cards, placed at "offset" (0 with the whole board if it was reset)
+    if (view.boardSize != last.boardSize) {
+        size_t offset = view.boardSize > last.boardSize ? last.boardSize : 0;
+        json cards = json::array();
+        const Board& board = room.poker->getBoard();
+        for (size_t i = offset; i < board.size(); i++) {
+            cards.push_back({
+                {"rank", room.poker->rankToString(board[i].rank)},
+                {"suit", room.poker->suitToString(board[i].suit)}
+            });
+        }
+        delta["board"] = {{"offset", offset}, {"cards", cards}};
+    }
+
+    json seats = json::array();
+    for (size_t i = 0; i < view.seats.size(); i++) {
+        const SeatView& now = view.seats[i];
+        const SeatView& before = last.seats[i];
+        json seat;
+        if (now.chips != before.chips) seat["chips"] = now.chips;
+        if (now.currentBet != before.currentBet) seat["current_bet"] = now.currentBet;
+        if (now.isActive != before.isActive) seat["is_active"] = now.isActive;
+        if (now.hasHand != before.hasHand) seat["has_hand"] = now.hasHand;
+        if (!seat.is_null()) {
+            seat["seat"] = i;
+            seats.push_back(seat);
+        }
+    }
+    if (!seats.empty()) {
+        delta["players"] = seats;
+    }
+    return delta;
+}
+
+std::string Server::compactState(const GameRoom& room) {
+    compact::GameState state;
+    state.gameId = room.gameID;
+    state.seq = room.stateSeq;
+    state.stage = compact::stageCode(room.gameStages);
+    state.pot = room.Pot;
+    state.currentBet = room.currentBet;
+    bool seated = room.currentPlayerIndex >= 0 && room.currentPlayerIndex < (int)room.players.size();
+    state.currentSeat = seated ? static_cast<uint8_t>(room.currentPlayerIndex) : compact::NO_SEAT;
+    for (const auto& card : room.poker->getBoard()) {
+        state.board.push(compact::cardCode(card));
+    }
     for (const auto& player : room.players) {
-        sendMessage(player.server_fd, stateMsg);
+        state.seats.push({static_cast<uint64_t>(player.chips), static_cast<uint64_t>(player.currentBet),
+                          seatFlags(player)});
     }
+    return compact::encode(state);
 }
 
-bool Server::handleAction(const json& request, int client_fd) {
-    std::lock_guard<std::mutex> lock(server_mutex);
-    
-    string username = request["username"];
-    int game_id = request["game_id"];
-    string actionStr = request["action"];
-    int amount = request.value("amount", 0); 
+// The table changed without a state broadcast (the reset between hands). Give the new state its
+// own seq so a resync snapshot never reuses the seq of a delta describing something else.
+void Server::newStateVersion(GameRoom& room) {
+    room.stateSeq++;
+    room.lastView = captureView(room);
+    room.lastAction = nullptr;
+}
 
-    json response = {{"type", "PLAY_TURN_RESPONSE"}};
+TableView Server::captureView(const GameRoom& room) {
+    TableView view;
+    view.stage = room.gameStages;
+    view.pot = room.Pot;
+    view.currentBet = room.currentBet;
+    view.currentPlayer = room.currentPlayerIndex;
+    view.boardSize = room.poker->getBoard().size();
+    view.seats.reserve(room.players.size());
+    for (const auto& player : room.players) {
+        view.seats.push_back({player.username, player.chips, player.currentBet, player.isActive, player.hasHand});
+    }
+    return view;
+}
 
-    // Check if player is in the game
-    auto playerInGame = playerToGameID.find(username);
-    if(playerInGame == playerToGameID.end() || playerInGame->second != game_id) {
+// A delta client that sees a gap in seq asks for the current table. Success is answered with a
+// GAME_STATE_SNAPSHOT, failure with a RESYNC_RESPONSE error.
+void Server::handleResync(const Request& request, int client_fd) {
+    int game_id = request.gameId.required();
+    const string& username = request.username.required();
+
+    json response = {{"type", "RESYNC_RESPONSE"}};
+
+    std::unique_lock<std::mutex> roomLock;
+    std::shared_ptr<GameRoom> room = lockRoom(game_id, roomLock);
+    if (!room) {
         response["status"] = "ERROR";
-        response["error"] = "Player not in session";
+        response["error"] = "Game not found";
         sendMessage(client_fd, response);
-        return false;
+        return;
     }
-
-    // Check for negative amount
-    if(amount < 0) {
+    if (room->playerIndex.find(username) == room->playerIndex.end()) {
         response["status"] = "ERROR";
-        response["error"] = "Cannot bet a negative amount";
+        response["error"] = "Player not found in game";
         sendMessage(client_fd, response);
-        return false;
+        return;
+    }
+    sendMessage(client_fd, stateSnapshot(*room, "GAME_STATE_SNAPSHOT"));
+}
+
+void Server::broadcastAllInEquity(GameRoom& room) {
+    // Only heads-up preflop spots are covered by the table
+    std::vector<const Player*> contenders;
+    for (const auto& player : room.players) {
+        if (player.hasHand) {
+            contenders.push_back(&player);
+        }
+    }
+    if (!preflopTable.isLoaded() || contenders.size() != 2) {
+        return;
     }
+    
+    double equity = preflopTable.equity(contenders[0]->holeCards, contenders[1]->holeCards);
+    if (equity < 0) {
+        return;
+    }
+    
+    json equityMsg = {
+        {"type", "ALL_IN_EQUITY"},
+        {"game_id", room.gameID},
+        {"stage", room.gameStages},
+        {"equities", json::array({
+            {{"username", contenders[0]->username}, {"equity", equity}},
+            {{"username", contenders[1]->username}, {"equity", 1.0 - equity}}
+        })}
+    };
+    
+    broadcast(room, equityMsg);
+}
+
+// Reply texts for a rejected turn, as the JSON protocol has always sent them
+static std::string turnError(const TurnOutcome& outcome) {
+    switch (outcome.result) {
+    case TurnResult::NOT_IN_SESSION:     return "Player not in session";
+    case TurnResult::NEGATIVE_AMOUNT:    return "Cannot bet a negative amount";
+    case TurnResult::GAME_NOT_FOUND:     return "Game not found";
+    case TurnResult::NOT_IN_PROGRESS:    return "Game not in progress";
+    case TurnResult::PLAYER_NOT_FOUND:   return "Player not found in game";
+    case TurnResult::NOT_YOUR_SEAT:      return "Not your seat";
+    case TurnResult::NOT_YOUR_TURN:      return "Not your turn";
+    case TurnResult::MUST_CALL_OR_FOLD:  return "Cannot check, must call or fold";
+    case TurnResult::ALREADY_BET:        return "Cannot bet, someone already bet. Use raise instead";
+    case TurnResult::BELOW_BIG_BLIND:    return "Bet must be at least big blind (" + std::to_string(outcome.amount) + ")";
+    case TurnResult::INSUFFICIENT_CHIPS: return "Insufficient chips";
+    case TurnResult::NO_BET_TO_RAISE:    return "No bet to raise, use BET instead";
+    case TurnResult::RAISE_TOO_SMALL:    return "Raise must be at least " + std::to_string(outcome.amount);
+    case TurnResult::NOTHING_TO_CALL:    return "Nothing to call";
+    default:                             return "Invalid action";
+    }
+}
+
+static std::string turnMessage(const string& username, ActionType action, int amount) {
+    switch (action) {
+    case ActionType::FOLD:   return username + " folded";
+    case ActionType::CHECK:  return username + " checked";
+    case ActionType::BET:    return username + " bet " + std::to_string(amount);
+    case ActionType::ALL_IN: return username + " went all in with " + std::to_string(amount);
+    case ActionType::RAISE:  return username + " raised to " + std::to_string(amount);
+    default:                 return username + " called " + std::to_string(amount);
+    }
+}
+
+bool Server::handleAction(const Request& request, int client_fd) {
+    const string& username = request.username.required();
+    ActionType action = request.action.required();
+    std::unique_lock<std::mutex> roomLock;
+    TurnOutcome outcome = playTurn(username, request.gameId.required(), -1, action,
+                                   request.amount.valueOr(0), roomLock);
 
-    // Find game room
-    auto roomIt = gameRooms.find(game_id);
-    if (roomIt == gameRooms.end()) {
+    json response = {{"type", "PLAY_TURN_RESPONSE"}};
+    if (outcome.result != TurnResult::OK) {
         response["status"] = "ERROR";
-        response["error"] = "Game not found";
+        response["error"] = turnError(outcome);
         sendMessage(client_fd, response);
         return false;
     }
+    response["status"] = "SUCCESS";
+    response["message"] = turnMessage(username, action, outcome.amount);
+    sendMessage(client_fd, response);
+
+    finishTurn(*outcome.room, username, action);
+    return true;
+}
+
+// Compact bodies are decoded into structs on the stack and a PLAY_TURN is answered with a compact
+// PlayTurnResponse, so checking and replying to a turn builds no JSON; it acts for the username
+// this connection registered. An accepted turn still allocates in the state update it broadcasts.
+void Server::dispatchCompact(Connection& conn, const char* body, size_t length)
+{
+    const uint8_t* data = reinterpret_cast<const uint8_t*>(body);
+    uint8_t tag = length > 0 ? data[0] : 0;
+
+    switch (tag) {
+    case compact::PlayTurn::TAG: {
+        compact::PlayTurn turn;
+        if (!compact::decode(data, length, turn)) {
+            throw std::runtime_error("Malformed compact message");
+        }
+        ActionType action = turn.action < static_cast<uint8_t>(ActionType::UNKNOWN)
+                          ? static_cast<ActionType>(turn.action) : ActionType::UNKNOWN;
+        int game_id = static_cast<int>(std::min<uint64_t>(turn.gameId, INT_MAX));
+        int amount = static_cast<int>(std::min<uint64_t>(turn.amount, INT_MAX));
+        // NO_SEAT means the bot did not name a seat, like -1 on the JSON path
+        int seat = turn.seat == compact::NO_SEAT ? -1 : turn.seat;
+        std::unique_lock<std::mutex> roomLock;
+        TurnOutcome outcome = playTurn(conn.username, game_id, seat, action, amount, roomLock);
+
+        compact::PlayTurnResponse reply;
+        reply.gameId = turn.gameId;
+        reply.result = static_cast<uint8_t>(outcome.result);
+        reply.amount = static_cast<uint64_t>(std::max(outcome.amount, 0));
+        std::string encoded = compact::encode(reply);
+        reactor->send(conn.fd, OutboundMessage{frameHeader(conn.type, conn.encoding, encoded.size()) + encoded});
+
+        if (outcome.result == TurnResult::OK) {
+            finishTurn(*outcome.room, conn.username, action);
+        }
+        break;
+    }
+    default: {
+        json response = {
+            {"type", "ERROR"},
+            {"error", "Unknown message type"}
+        };
+        sendMessage(conn.fd, response);
+        break;
+    }
+    }
+}
+
+TurnOutcome Server::playTurn(const string& username, int game_id, int seat, ActionType action, int amount,
+                             std::unique_lock<std::mutex>& roomLock) {
+    // Check if player is in the game
+    {
+        std::lock_guard<std::mutex> lock(registryLock);
+        auto playerInGame = playerToGameID.find(username);
+        if(playerInGame == playerToGameID.end() || playerInGame->second != game_id) {
+            return TurnOutcome{TurnResult::NOT_IN_SESSION};
+        }
+    }
+
+    // Check for negative amount
+    if(amount < 0) {
+        return TurnOutcome{TurnResult::NEGATIVE_AMOUNT};
+    }
+
+    // Find game room; everything below runs under its lock
+    std::shared_ptr<GameRoom> roomPtr = lockRoom(game_id, roomLock);
+    if (!roomPtr) {
+        return TurnOutcome{TurnResult::GAME_NOT_FOUND};
+    }
     
-    GameRoom& room = roomIt->second;
+    GameRoom& room = *roomPtr;
     
     // Check game is in progress
     if (room.gameStages == "WAITING" || room.gameStages == "SHOWDOWN") {
-        response["status"] = "ERROR";
-        response["error"] = "Game not in progress";
-        sendMessage(client_fd, response);
-        return false;
+        return TurnOutcome{TurnResult::NOT_IN_PROGRESS};
     }
     
     // Check if it's player's turn
     auto playerIdxIt = room.playerIndex.find(username);
     if (playerIdxIt == room.playerIndex.end()) {
-        response["status"] = "ERROR";
-        response["error"] = "Player not found in game";
-        sendMessage(client_fd, response);
-        return false;
+        return TurnOutcome{TurnResult::PLAYER_NOT_FOUND};
     }
     
     int playerIdx = playerIdxIt->second;
+
+    if (seat >= 0 && seat != playerIdx) {
+        return TurnOutcome{TurnResult::NOT_YOUR_SEAT};
+    }
     
     if (playerIdx != room.currentPlayerIndex) {
-        response["status"] = "ERROR";
-        response["error"] = "Not your turn";
-        sendMessage(client_fd, response);
-        return false;
+        return TurnOutcome{TurnResult::NOT_YOUR_TURN};
     }
     
     Player& player = room.players[playerIdx];
 
-    // Parse action type
-    ActionType action = getActionType(actionStr);
     if (action == ActionType::UNKNOWN) {
-        response["status"] = "ERROR";
-        response["error"] = "Invalid action";
-        sendMessage(client_fd, response);
-        return false;
+        return TurnOutcome{TurnResult::INVALID_ACTION};
     }
 
     // Handle each action type
+    int moved = 0;
     switch(action) {
         case ActionType::FOLD: {
             player.hasHand = false;
             player.isActive = false;
-            response["status"] = "SUCCESS";
-            response["message"] = username + " folded";
+            moved = 0;
             break;
         }
         case ActionType::CHECK: {
             // Can only check if current bet is 0 or player has already matched it
             if(room.currentBet != player.currentBet) {
-                response["status"] = "ERROR";
-                response["error"] = "Cannot check, must call or fold";
-                sendMessage(client_fd, response);
-                return false;
+                return TurnOutcome{TurnResult::MUST_CALL_OR_FOLD};
             }
-            response["status"] = "SUCCESS";
-            response["message"] = username + " checked";
+            moved = 0;
             break;
         }
         case ActionType::BET: {
             // Can only bet if no one has bet yet
             if(room.currentBet != 0) {
-                response["status"] = "ERROR";
-                response["error"] = "Cannot bet, someone already bet. Use raise instead";
-                sendMessage(client_fd, response);
-                return false;
+                return TurnOutcome{TurnResult::ALREADY_BET};
             }
             
             // Bet must be at least big blind
             if(amount < room.bigBlind) {
-                response["status"] = "ERROR";
-                response["error"] = "Bet must be at least big blind (" + std::to_string(room.bigBlind) + ")";
-                sendMessage(client_fd, response);
-                return false;
+                return TurnOutcome{TurnResult::BELOW_BIG_BLIND, room.bigBlind};
             }
             
             // Check if player has enough chips
             if(amount > player.chips) {
-                response["status"] = "ERROR";
-                response["error"] = "Insufficient chips";
-                sendMessage(client_fd, response);
-                return false;
+                return TurnOutcome{TurnResult::INSUFFICIENT_CHIPS};
             }
             
             room.Pot += amount; 
@@ -1313,8 +2075,7 @@ bool Server::handleAction(const json& request, int client_fd) {
             room.currentBet = player.currentBet;
             room.lastRaiser = playerIdx;
             room.hasActedThisRound.clear();  // Reset - everyone needs to act again
-            response["status"] = "SUCCESS";
-            response["message"] = username + " bet " + std::to_string(amount);
+            moved = amount;
             break;
         }
         case ActionType::ALL_IN: {
@@ -1330,25 +2091,18 @@ bool Server::handleAction(const json& request, int client_fd) {
                 room.lastRaiser = playerIdx;
                 room.hasActedThisRound.clear();
             }
-            response["status"] = "SUCCESS";
-            response["message"] = username + " went all in with " + std::to_string(allInAmount);
+            moved = allInAmount;
             break;
         }
         case ActionType::RAISE: {
             // Raise amount is the TOTAL bet, not the additional amount
             if(room.currentBet == 0) {
-                response["status"] = "ERROR";
-                response["error"] = "No bet to raise, use BET instead";
-                sendMessage(client_fd, response);
-                return false;
+                return TurnOutcome{TurnResult::NO_BET_TO_RAISE};
             }
             
             int minRaise = room.currentBet * 2;
             if(amount < minRaise) {
-                response["status"] = "ERROR";
-                response["error"] = "Raise must be at least " + std::to_string(minRaise);
-                sendMessage(client_fd, response);
-                return false;
+                return TurnOutcome{TurnResult::RAISE_TOO_SMALL, minRaise};
             }
             
             // Calculate how much more player needs to put in
@@ -1356,10 +2110,7 @@ bool Server::handleAction(const json& request, int client_fd) {
             
             // Check if player has enough chips
             if(raiseAmount > player.chips) {
-                response["status"] = "ERROR";
-                response["error"] = "Insufficient chips";
-                sendMessage(client_fd, response);
-                return false;
+                return TurnOutcome{TurnResult::INSUFFICIENT_CHIPS};
             }
             
             room.Pot += raiseAmount;
@@ -1368,8 +2119,7 @@ bool Server::handleAction(const json& request, int client_fd) {
             room.currentBet = amount;
             room.lastRaiser = playerIdx;
             room.hasActedThisRound.clear();  // Everyone needs to act again
-            response["status"] = "SUCCESS";
-            response["message"] = username + " raised to " + std::to_string(amount);
+            moved = amount;
             break;
         }
         case ActionType::CALL: {
@@ -1377,10 +2127,7 @@ bool Server::handleAction(const json& request, int client_fd) {
             int callAmount = room.currentBet - player.currentBet;
             
             if(callAmount <= 0) {
-                response["status"] = "ERROR";
-                response["error"] = "Nothing to call";
-                sendMessage(client_fd, response);
-                return false;
+                return TurnOutcome{TurnResult::NOTHING_TO_CALL};
             }
             
             // Check if player has enough chips (if not, it's an all-in)
@@ -1392,23 +2139,26 @@ bool Server::handleAction(const json& request, int client_fd) {
             room.Pot += callAmount; 
             player.chips -= callAmount;
             player.currentBet += callAmount;
-            response["status"] = "SUCCESS";
-            response["message"] = username + " called " + std::to_string(callAmount);
+            moved = callAmount;
             break;
         }
         default: {
-            response["status"] = "ERROR";
-            response["error"] = "Unknown action type";  
-            sendMessage(client_fd, response);
-            return false;
+            return TurnOutcome{TurnResult::INVALID_ACTION};
         }
     }
     
     // Mark player as having acted
     room.hasActedThisRound[username] = true;
+    room.lastAction = {
+        {"seat", playerIdx},
+        {"action", actionName(action)}
+    };
     
-    sendMessage(client_fd, response);
-    
+    return TurnOutcome{TurnResult::OK, moved, roomPtr};
+}
+
+// Runs after the acting player has had their reply, with the room still locked
+void Server::finishTurn(GameRoom& room, const string& username, ActionType action) {
     // Count active handle
     int activePlayers = 0;
     int playersWithHand = 0;
@@ -1429,7 +2179,7 @@ bool Server::handleAction(const json& request, int client_fd) {
                 
                 json winMsg = {
                     {"type", "GAME_OVER"},
-                    {"game_id", game_id},
+                    {"game_id", room.gameID},
                     {"winner", p.username},
                     {"pot", room.Pot},
                     {"reason", "All other players folded"},
@@ -1443,19 +2193,18 @@ bool Server::handleAction(const json& request, int client_fd) {
                     });
                 }
                 
-                for (const auto& player : room.players) {
-                    sendMessage(player.server_fd, winMsg);
-                }
+                broadcast(room, winMsg);
                 
                 room.gameStages = "WAITING";
                 room.Pot = 0;
                 room.currentBet = 0;
                 room.buttonPosition = (room.buttonPosition + 1) % room.players.size();
                 room.hasActedThisRound.clear();
+                newStateVersion(room);
                 break;
             }
         }
-        return true;
+        return;
     }
     
     // Move to next active player
@@ -1475,6 +2224,10 @@ bool Server::handleAction(const json& request, int client_fd) {
     if (isBettingRoundComplete(room) || activePlayers <= 1) {
         // If everyone is all-in or only one active player, deal remaining cards
         if (activePlayers <= 1 && playersWithHand > 1) {
+            if (room.gameStages == "PREFLOP") {
+                broadcastAllInEquity(room);
+            }
+            
             // Run out the board
             while (room.gameStages != "RIVER" && room.gameStages != "SHOWDOWN") {
                 if (room.gameStages == "PREFLOP") {
@@ -1498,6 +2251,5 @@ bool Server::handleAction(const json& request, int client_fd) {
         broadcastGameState(room);
     }
     
-    cout << "Action processed: " << username << " - " << actionStr << endl;
-    return true; 
+    LOG_DEBUG(GAME, "Action processed: " << username << " - " << actionName(action));
 }
\ No newline at end of file
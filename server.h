@@ -6,11 +6,18 @@
 #include <unordered_map>
 #include <vector>
 #include <memory>
+#include <functional>
+#include <mutex>
+#include <shared_mutex>
 #include <netinet/in.h>
 #include <arpa/inet.h>
 #include <unistd.h>
 #include "json.hpp"
 #include "poker.h"
+#include "preflop.h"
+#include "reactor.h"
+#include "request.h"
+#include "config.h"
 
 using json = nlohmann::json;
 using std::string;
@@ -20,48 +27,43 @@ using std::endl;
 
 const int MAX_PLAYERS = 9;
 
-//TODO: Leadership Board, game chat
-enum class MessageType {
-    LOGIN,
-    REGISTER,
-    CREATE_GAME,
-    JOIN_GAME,
-    EXIT_GAME,
-    UNREGISTER,
-    START_GAME,
-    PLAY_TURN,
-    LIST_GAMES,
-    UNKNOWN
-};
-
-enum class ActionType {
-    FOLD,
-    CHECK,
-    CALL,
-    BET,
-    RAISE,
-    ALL_IN,
-    UNKNOWN
-};
-
-enum class ClientType {
-    TCP,
-    WEBSOCKET
-};
-
 struct Player {
     string username;
     int server_fd;
     int gameRoomID;
     int chips;
-    std::vector<Card> holeCards;
+    HoleCards holeCards;
     bool hasHand;
     int currentBet;
     bool isActive;
     ClientType clientType;
+    WireEncoding encoding;
+    std::shared_ptr<DeflateSession> deflate;    // Compression state if the client negotiated it
+    bool deltaUpdates;      // Gets GAME_STATE_DELTA instead of full GAME_STATE_UPDATEs
 };
 
+// Table state as of the last broadcast, the baseline the next GAME_STATE_DELTA is computed from
+struct SeatView {
+    string username;
+    int chips;
+    int currentBet;
+    bool isActive;
+    bool hasHand;
+};
+
+struct TableView {
+    string stage;
+    int pot = 0;
+    int currentBet = 0;
+    int currentPlayer = -1;
+    size_t boardSize = 0;
+    std::vector<SeatView> seats;
+};
+
+// Each room is guarded by its own lock, so tables progress independently on the reactor threads
 struct GameRoom {
+    std::mutex lock;
+    bool closed = false;    // Removed from the server; late lookups must treat it as gone
     int gameID;
     int smallBlind;
     int bigBlind;
@@ -75,54 +77,122 @@ struct GameRoom {
     std::unordered_map<string, bool> hasActedThisRound;
     int lastRaiser;
     std::unique_ptr<Poker> poker;
+    uint64_t stateSeq = 0;  // Bumped by every state broadcast; clients resync on a gap
+    TableView lastView;
+    json lastAction;        // Action since the last broadcast, reported in the next delta
+};
+
+// Outcome of a PLAY_TURN. Compact clients receive the number, so values are only ever appended.
+enum class TurnResult : uint8_t {
+    OK,
+    NOT_IN_SESSION,
+    NEGATIVE_AMOUNT,
+    GAME_NOT_FOUND,
+    NOT_IN_PROGRESS,
+    PLAYER_NOT_FOUND,
+    NOT_YOUR_SEAT,
+    NOT_YOUR_TURN,
+    INVALID_ACTION,
+    MUST_CALL_OR_FOLD,
+    ALREADY_BET,
+    BELOW_BIG_BLIND,
+    INSUFFICIENT_CHIPS,
+    NO_BET_TO_RAISE,
+    RAISE_TOO_SMALL,
+    NOTHING_TO_CALL
+};
+
+struct TurnOutcome {
+    TurnResult result = TurnResult::OK;
+    int amount = 0;                     // Chips moved, or the minimum for BELOW_BIG_BLIND / RAISE_TOO_SMALL
+    std::shared_ptr<GameRoom> room;     // Set when the turn was accepted
 };
 
-class Server {
+class Server : public ConnectionHandler {
 private:
+    ServerConfig config;
     int server_fd;
     int ws_server_fd;
+    // Lock order: roomsLock, then a room's lock, then registryLock. sendMessage only queues
+    // bytes on the reactor, so it is fine to call with any of them held.
+    std::shared_mutex roomsLock;    // Guards gameRooms, nextGameID and freeGameID (not the rooms)
     int nextGameID;
     std::vector<int> freeGameID;
+    std::unordered_map<int, std::shared_ptr<GameRoom>> gameRooms;
+    std::mutex registryLock;        // Guards registeredPlayers and playerToGameID
     std::unordered_map<string, int> registeredPlayers;
-    std::unordered_map<int, GameRoom> gameRooms;
     std::unordered_map<string, int> playerToGameID;
-    std::unordered_map<int, ClientType> clientTypes;
+    PreflopTable preflopTable;  // mmapped heads-up preflop equities (optional)
+    std::unique_ptr<Reactor> reactor;  // Owns every client socket
 
     // WebSocket helper functions
     std::string base64Encode(const unsigned char* data, size_t len);
-    bool performWebSocketHandshake(int client_fd);
-    json receiveWebSocketMessage(int client_fd);
-    void sendWebSocketMessage(int client_fd, const json& message);
+    bool performWebSocketHandshake(Connection& conn, size_t& offset);
+    bool nextWebSocketMessage(Connection& conn, size_t& offset, Request& request);
 
-    // Message type parsing
-    MessageType getMessageType(const std::string &typeStr);
-    ActionType getActionType(const std::string &typeStr);
+    // Message handling. next*Message parse one message starting at conn.input[offset] and
+    // advance offset past it; they return false while the message is still incomplete.
+    bool nextMessage(Connection& conn, size_t& offset, Request& request);
+    // coalesceKey: a newer message with the same key replaces this one if it is still queued
+    void sendMessage(int clientSocket, const json &message, uint64_t coalesceKey = 0);
+    void dispatch(Connection& conn, const Request& request);
 
-    // Message handling
-    json receiveMessage(int clientSocket);
-    void sendMessage(int clientSocket, const json &message);
-    void handleClient(int client_fd, ClientType clientType);
+    // Room fan-out: the payload is serialized once and its buffer shared by every recipient.
+    // Compact clients get compactBody() instead when the message has a compact form.
+    void broadcast(const GameRoom& room, const json& message, uint64_t coalesceKey = 0,
+                   const std::function<bool(const Player&)>& include = nullptr,
+                   const std::function<std::string()>& compactBody = nullptr);
+    // As broadcast, with privateFields(seat) spliced into each player's copy; only those bytes
+    // are built per player. Compact clients get compactBody(seat).
+    void broadcastWithPrivate(const GameRoom& room, const json& shared,
+                              const std::function<json(size_t)>& privateFields,
+                              const std::function<std::string(size_t)>& compactBody = nullptr);
+
+    // Reactor callbacks
+    void onOpen(Connection& conn) override;
+    void onData(Connection& conn) override;
+    void onClose(Connection& conn) override;
+    size_t inputLimit(const Connection& conn) const override;
 
     // Command handlers
-    void handleRegister(const json &request, int client_fd, std::string &client_username);
-    void handleListGames(const json &request, int client_fd);
-    void handleCreateGame(const json &request, int client_fd);
-    void handleJoinGame(const json &request, int client_fd);
-    void handleExitGame(const json &request, int client_fd);
-    void handleUnregister(const json &request, int client_fd, std::string &client_username);
-    void handleStartGame(const json& request, int client_fd);
-    void handleChat(const json& request, int client_fd); //TODO 
-    bool handleAction(const json& request, int client_fd);
+    void handleRegister(const Request &request, int client_fd, std::string &client_username);
+    void handleListGames(const Request &request, int client_fd);
+    void handleCreateGame(const Request &request, int client_fd);
+    void handleJoinGame(const Request &request, int client_fd);
+    void handleExitGame(const Request &request, int client_fd);
+    void handleUnregister(const Request &request, int client_fd, std::string &client_username);
+    void handleStartGame(const Request& request, int client_fd);
+    void handleChat(const Request& request, int client_fd); //TODO 
+    bool handleAction(const Request& request, int client_fd);
+    // PLAY_TURN from either protocol; a non-negative seat must be the player's own. Checks and
+    // applies the action; an accepted one returns with the room still locked through roomLock,
+    // so the caller can reply before finishTurn moves the hand on and broadcasts.
+    TurnOutcome playTurn(const string& username, int game_id, int seat, ActionType action, int amount,
+                         std::unique_lock<std::mutex>& roomLock);
+    void finishTurn(GameRoom& room, const string& username, ActionType action);
+    void dispatchCompact(Connection& conn, const char* body, size_t length);
+    void handleResync(const Request& request, int client_fd);
+
+    // Room ownership
+    std::shared_ptr<GameRoom> lockRoom(int game_id, std::unique_lock<std::mutex>& lock);
+    bool removePlayer(GameRoom& room, const string& username);
+    void releaseRoomIfEmpty(int game_id);
 
     // Game logic helpers
     bool isBettingRoundComplete(GameRoom& room);
     void advanceGameStage(GameRoom& room);
     void handleShowdown(GameRoom& room);
     void broadcastGameState(GameRoom& room);
+    json stateSnapshot(const GameRoom& room, const char* type);
+    json stateDelta(const GameRoom& room, const TableView& view);
+    std::string compactState(const GameRoom& room);
+    TableView captureView(const GameRoom& room);
+    void newStateVersion(GameRoom& room);
+    void broadcastAllInEquity(GameRoom& room);
     
     
 public:
-    Server();
+    explicit Server(const ServerConfig& config = ServerConfig());
     ~Server();
     void run();
 };
@@ -0,0 +1,622 @@
+#include "uring.h"
+#include "log.h"
+#include <stdexcept>
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/socket.h>
+#include <sys/syscall.h>
+#include <sys/eventfd.h>
+
+static const unsigned RING_ENTRIES = 1024;
+static const unsigned BUFFER_COUNT = 256;          // Provided buffers per loop (a power of two)
+static const unsigned BUFFER_SIZE = 16 * 1024;
+static const int BUFFER_GROUP = 0;
+
+// user_data is a Connection pointer (8-byte aligned) with the operation in the low bits
+enum OpTag : uint64_t {
+    OP_RECV = 0,
+    OP_SEND = 1,
+    OP_ACCEPT = 2,
+    OP_WAKE = 3,
+    OP_PROBE = 4,
+    OP_SWEEP = 6
+};
+static const uint64_t OP_MASK = 7;
+
+static uint64_t userData(const Connection* conn, OpTag op) {
+    return reinterpret_cast<uint64_t>(conn) | op;
+}
+
+// io_uring waits in the kernel instead of returning EAGAIN, so its sockets stay blocking
+static void setBlocking(int fd) {
+    int flags = fcntl(fd, F_GETFL, 0);
+    if (flags >= 0) {
+        fcntl(fd, F_SETFL, flags & ~O_NONBLOCK);
+    }
+}
+
+// The loop the current thread runs, so sends from inside a handler skip the eventfd wake-up
+static thread_local const void* currentLoop = nullptr;
+
+IoRing::IoRing(unsigned entries) : ringFd(-1), ringPtr(MAP_FAILED), sqes(nullptr) {
+    io_uring_params params;
+    memset(&params, 0, sizeof(params));
+    params.flags = IORING_SETUP_CQSIZE;
+    params.cq_entries = entries * 4;
+
+    ringFd = static_cast<int>(syscall(__NR_io_uring_setup, entries, &params));
+    if (ringFd < 0) {
+        throw std::runtime_error(std::string("io_uring_setup: ") + strerror(errno));
+    }
+    if (!(params.features & IORING_FEAT_SINGLE_MMAP) || !(params.features & IORING_FEAT_NODROP)) {
+        ::close(ringFd);
+        throw std::runtime_error("kernel io_uring is too old");
+    }
+
+    size_t sqSize = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+    size_t cqSize = params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe);
+    ringSize = std::max(sqSize, cqSize);
+    ringPtr = mmap(nullptr, ringSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ringFd, IORING_OFF_SQ_RING);
+    sqesSize = params.sq_entries * sizeof(io_uring_sqe);
+    void* sqePtr = mmap(nullptr, sqesSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ringFd, IORING_OFF_SQES);
+    if (ringPtr == MAP_FAILED || sqePtr == MAP_FAILED) {
+        ::close(ringFd);
+        throw std::runtime_error("failed to map io_uring queues");
+    }
+
+    char* base = static_cast<char*>(ringPtr);
+    sqes = static_cast<io_uring_sqe*>(sqePtr);
+    sqEntries = params.sq_entries;
+    sqHead = reinterpret_cast<unsigned*>(base + params.sq_off.head);
+    sqTail = reinterpret_cast<unsigned*>(base + params.sq_off.tail);
+    sqMask = reinterpret_cast<unsigned*>(base + params.sq_off.ring_mask);
+    cqHead = reinterpret_cast<unsigned*>(base + params.cq_off.head);
+    cqTail = reinterpret_cast<unsigned*>(base + params.cq_off.tail);
+    cqMask = reinterpret_cast<unsigned*>(base + params.cq_off.ring_mask);
+    cqes = reinterpret_cast<io_uring_cqe*>(base + params.cq_off.cqes);
+    sqLocalTail = *sqTail;
+    cqLocalHead = *cqHead;
+    toSubmit = 0;
+
+    // SQEs are always filled in ring order, so the indirection array is the identity
+    unsigned* sqArray = reinterpret_cast<unsigned*>(base + params.sq_off.array);
+    for (unsigned i = 0; i < sqEntries; i++) {
+        sqArray[i] = i;
+    }
+}
+
+IoRing::~IoRing() {
+    if (sqes) {
+        munmap(sqes, sqesSize);
+    }
+    if (ringPtr != MAP_FAILED) {
+        munmap(ringPtr, ringSize);
+    }
+    if (ringFd >= 0) {
+        ::close(ringFd);
+    }
+}
+
+void IoRing::registerBufferRing(io_uring_buf_ring* bufferRing, unsigned entries, unsigned group) {
+    io_uring_buf_reg reg;
+    memset(&reg, 0, sizeof(reg));
+    reg.ring_addr = reinterpret_cast<uint64_t>(bufferRing);
+    reg.ring_entries = entries;
+    reg.bgid = static_cast<uint16_t>(group);
+    if (syscall(__NR_io_uring_register, ringFd, IORING_REGISTER_PBUF_RING, &reg, 1) < 0) {
+        throw std::runtime_error(std::string("io_uring buffer ring: ") + strerror(errno));
+    }
+}
+
+io_uring_sqe* IoRing::getSqe() {
+    if (sqLocalTail - __atomic_load_n(sqHead, __ATOMIC_ACQUIRE) >= sqEntries) {
+        submit(0);
+        if (sqLocalTail - __atomic_load_n(sqHead, __ATOMIC_ACQUIRE) >= sqEntries) {
+            return nullptr;
+        }
+    }
+    io_uring_sqe* sqe = &sqes[sqLocalTail & *sqMask];
+    memset(sqe, 0, sizeof(*sqe));
+    sqLocalTail++;
+    toSubmit++;
+    return sqe;
+}
+
+int IoRing::submit(unsigned waitFor) {
+    __atomic_store_n(sqTail, sqLocalTail, __ATOMIC_RELEASE);
+    while (true) {
+        long ret = syscall(__NR_io_uring_enter, ringFd, toSubmit, waitFor,
+                           waitFor ? IORING_ENTER_GETEVENTS : 0, nullptr, 0);
+        if (ret >= 0) {
+            toSubmit -= static_cast<unsigned>(ret);
+            return static_cast<int>(ret);
+        }
+        if (errno == EINTR) {
+            continue;
+        }
+        // EAGAIN/EBUSY: the completion queue needs reaping first; the caller will come back
+        return -errno;
+    }
+}
+
+UringReactor::UringReactor(ConnectionHandler& handler, const ServerConfig& config)
+    : Reactor(handler, config), nextLoop(0) {
+    for (int i = 0; i < this->numThreads; i++) {
+        auto loop = std::make_unique<Loop>();
+        loop->index = i;
+        loop->ring = std::make_unique<IoRing>(RING_ENTRIES);
+        loop->wakeFd = eventfd(0, EFD_CLOEXEC);
+        loop->wakePending = false;
+
+        void* bufferMem = mmap(nullptr, static_cast<size_t>(BUFFER_COUNT) * BUFFER_SIZE, PROT_READ | PROT_WRITE,
+                               MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+        void* ringMem = mmap(nullptr, BUFFER_COUNT * sizeof(io_uring_buf), PROT_READ | PROT_WRITE,
+                             MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+        if (loop->wakeFd < 0 || bufferMem == MAP_FAILED || ringMem == MAP_FAILED) {
+            throw std::runtime_error("failed to allocate io_uring buffers");
+        }
+        loop->buffers = static_cast<char*>(bufferMem);
+        loop->bufferRing = static_cast<io_uring_buf_ring*>(ringMem);
+        loop->bufferTail = 0;
+        loop->ring->registerBufferRing(loop->bufferRing, BUFFER_COUNT, BUFFER_GROUP);
+        for (unsigned id = 0; id < BUFFER_COUNT; id++) {
+            recycleBuffer(*loop, id);
+        }
+        loops.push_back(std::move(loop));
+    }
+    probeMultishotRecv(*loops[0]);
+}
+
+UringReactor::~UringReactor() {
+    stop();
+    for (auto& thread : threads) {
+        if (thread.joinable()) {
+            thread.join();
+        }
+    }
+    for (auto& loop : loops) {
+        for (auto& entry : loop->owned) {
+            ::close(entry.first->fd);
+        }
+        loop->ring.reset();
+        munmap(loop->buffers, static_cast<size_t>(BUFFER_COUNT) * BUFFER_SIZE);
+        munmap(loop->bufferRing, BUFFER_COUNT * sizeof(io_uring_buf));
+        ::close(loop->wakeFd);
+    }
+}
+
+// Multishot recv (Linux 6.0) is the newest feature relied on; try it once on a socketpair
+void UringReactor::probeMultishotRecv(Loop& loop) {
+    int pair[2];
+    if (socketpair(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0, pair) < 0) {
+        throw std::runtime_error("socketpair failed");
+    }
+    io_uring_sqe* sqe = nextSqe(loop);
+    sqe->opcode = IORING_OP_RECV;
+    sqe->fd = pair[0];
+    sqe->ioprio = IORING_RECV_MULTISHOT;
+    sqe->flags = IOSQE_BUFFER_SELECT;
+    sqe->buf_group = BUFFER_GROUP;
+    sqe->user_data = userData(nullptr, OP_PROBE);
+    ssize_t ignored = write(pair[1], "x", 1);
+    (void)ignored;
+
+    bool supported = false;
+    bool finished = false;
+    while (!finished) {
+        if (loop.ring->submit(1) < 0) {
+            break;
+        }
+        unsigned head = loop.ring->cqHeadIndex();
+        for (; head != loop.ring->cqTailIndex(); head++) {
+            const io_uring_cqe& cqe = *loop.ring->cqe(head);
+            if (cqe.flags & IORING_CQE_F_BUFFER) {
+                recycleBuffer(loop, cqe.flags >> IORING_CQE_BUFFER_SHIFT);
+            }
+            if (cqe.res == 1 && (cqe.flags & IORING_CQE_F_MORE)) {
+                supported = true;
+                ::close(pair[1]);   // EOF ends the multishot request
+                pair[1] = -1;
+            }
+            if (!(cqe.flags & IORING_CQE_F_MORE)) {
+                finished = true;
+            }
+        }
+        loop.ring->advanceCq(head);
+    }
+    ::close(pair[0]);
+    if (pair[1] >= 0) {
+        ::close(pair[1]);
+    }
+    if (!supported) {
+        throw std::runtime_error("multishot recv is not supported");
+    }
+}
+
+// The kernel stops taking submissions while completions wait to be reaped (the CQ overflowed).
+// They are moved aside rather than handled here, since this may run inside a handler.
+io_uring_sqe* UringReactor::nextSqe(Loop& loop) {
+    io_uring_sqe* sqe = loop.ring->getSqe();
+    while (!sqe) {
+        unsigned head = loop.ring->cqHeadIndex();
+        for (; head != loop.ring->cqTailIndex(); head++) {
+            loop.stashed.push_back(*loop.ring->cqe(head));
+        }
+        loop.ring->advanceCq(head);
+        sqe = loop.ring->getSqe();
+    }
+    return sqe;
+}
+
+// Oldest unhandled completion: stashed ones first, then the ring. Each is released before it is
+// handled, so a handler that stashes more never sees it again.
+bool UringReactor::nextCompletion(Loop& loop, io_uring_cqe& cqe) {
+    if (loop.stashedNext < loop.stashed.size()) {
+        cqe = loop.stashed[loop.stashedNext++];
+        return true;
+    }
+    loop.stashed.clear();
+    loop.stashedNext = 0;
+    unsigned head = loop.ring->cqHeadIndex();
+    if (head == loop.ring->cqTailIndex()) {
+        return false;
+    }
+    cqe = *loop.ring->cqe(head);
+    loop.ring->advanceCq(head + 1);
+    return true;
+}
+
+// Hand a receive buffer back to the kernel: fill the next ring slot and publish the new tail.
+// The kernel sees it on its next pick, with no SQE and no syscall.
+void UringReactor::recycleBuffer(Loop& loop, unsigned bufferId) {
+    // Indexed by hand: in C++ the header's flexible-array wrapper shifts bufs by 8 bytes
+    io_uring_buf* slots = reinterpret_cast<io_uring_buf*>(loop.bufferRing);
+    io_uring_buf& slot = slots[loop.bufferTail & (BUFFER_COUNT - 1)];
+    slot.addr = reinterpret_cast<uint64_t>(loop.buffers + static_cast<size_t>(bufferId) * BUFFER_SIZE);
+    slot.len = BUFFER_SIZE;
+    slot.bid = static_cast<uint16_t>(bufferId);    // Leaves resv alone: slot 0's overlays the tail
+    loop.bufferTail++;
+    __atomic_store_n(&loop.bufferRing->tail, loop.bufferTail, __ATOMIC_RELEASE);
+}
+
+void UringReactor::listen(int fd, ClientType type) {
+    setBlocking(fd);
+    listeners.push_back(std::make_shared<Connection>(fd, type, true, -1));
+}
+
+void UringReactor::adopt(int fd, ClientType type) {
+    setBlocking(fd);
+    tuneSocket(fd);
+    int index = static_cast<int>(nextLoop++ % loops.size());
+    auto conn = std::make_shared<Connection>(fd, type, false, index);
+    registerConnection(conn);
+    handler.onOpen(*conn);
+
+    Loop& loop = *loops[index];
+    {
+        std::lock_guard<std::mutex> lock(loop.pendingLock);
+        loop.pendingAdopt.push_back(conn);
+    }
+    wake(loop);
+}
+
+bool UringReactor::send(int fd, OutboundMessage message) {
+    std::shared_ptr<Connection> conn = find(fd);
+    if (!conn) {
+        return false;
+    }
+
+    std::lock_guard<std::mutex> lock(conn->outputLock);
+    if (conn->closed || conn->closing) {
+        return false;
+    }
+    if (!enqueue(*conn, std::move(message))) {
+        return false;
+    }
+    if (!conn->flushQueued) {
+        conn->flushQueued = true;
+        Loop& loop = *loops[conn->loop];
+        {
+            std::lock_guard<std::mutex> pending(loop.pendingLock);
+            loop.pendingFlush.push_back(conn);
+        }
+        wake(loop);
+    }
+    return true;
+}
+
+void UringReactor::close(int fd) {
+    std::shared_ptr<Connection> conn = find(fd);
+    if (conn) {
+        std::lock_guard<std::mutex> lock(conn->outputLock);
+        requestClose(*conn);
+    }
+}
+
+// The owning loop drains its pending lists before every io_uring_enter, so it only needs an
+// eventfd write when the request comes from another thread and none is outstanding
+void UringReactor::wake(Loop& loop) {
+    if (currentLoop == &loop) {
+        return;
+    }
+    if (!loop.wakePending.exchange(true)) {
+        uint64_t one = 1;
+        ssize_t ignored = write(loop.wakeFd, &one, sizeof(one));
+        (void)ignored;
+    }
+}
+
+void UringReactor::armWake(Loop& loop) {
+    io_uring_sqe* sqe = nextSqe(loop);
+    sqe->opcode = IORING_OP_READ;
+    sqe->fd = loop.wakeFd;
+    sqe->addr = reinterpret_cast<uint64_t>(&loop.wakeValue);
+    sqe->len = sizeof(loop.wakeValue);
+    sqe->user_data = userData(nullptr, OP_WAKE);
+}
+
+void UringReactor::armSweep(Loop& loop) {
+    io_uring_sqe* sqe = nextSqe(loop);
+    sqe->opcode = IORING_OP_TIMEOUT;
+    sqe->addr = reinterpret_cast<uint64_t>(&loop.sweepInterval);
+    sqe->len = 1;
+    sqe->user_data = userData(nullptr, OP_SWEEP);
+}
+
+void UringReactor::armAccept(Loop& loop, Connection& listener) {
+    io_uring_sqe* sqe = nextSqe(loop);
+    sqe->opcode = IORING_OP_ACCEPT;
+    sqe->fd = listener.fd;
+    sqe->ioprio = IORING_ACCEPT_MULTISHOT;
+    sqe->accept_flags = SOCK_CLOEXEC;
+    sqe->user_data = userData(&listener, OP_ACCEPT);
+}
+
+void UringReactor::armRecv(Loop& loop, Connection& conn) {
+    io_uring_sqe* sqe = nextSqe(loop);
+    sqe->opcode = IORING_OP_RECV;
+    sqe->fd = conn.fd;
+    sqe->ioprio = IORING_RECV_MULTISHOT;
+    sqe->flags = IOSQE_BUFFER_SELECT;
+    sqe->buf_group = BUFFER_GROUP;
+    sqe->user_data = userData(&conn, OP_RECV);
+    conn.recvArmed = true;
+    conn.pendingOps++;
+}
+
+void UringReactor::submitSend(Loop& loop, Connection& conn, int flags) {
+    conn.sendSegments.resize(MAX_GATHER_SEGMENTS);
+    conn.sendHeader = msghdr{};
+    conn.sendHeader.msg_iov = conn.sendSegments.data();
+    conn.sendHeader.msg_iovlen = conn.sending.gather(conn.sendSegments.data(), MAX_GATHER_SEGMENTS);
+
+    io_uring_sqe* sqe = nextSqe(loop);
+    sqe->opcode = IORING_OP_SENDMSG;
+    sqe->fd = conn.fd;
+    sqe->addr = reinterpret_cast<uint64_t>(&conn.sendHeader);
+    sqe->len = 1;
+    sqe->msg_flags = MSG_NOSIGNAL | flags;
+    sqe->user_data = userData(&conn, OP_SEND);
+    conn.pendingOps++;
+}
+
+// Move the queued messages (not their bytes) in flight, where coalescing cannot touch them, and
+// hand them to the kernel as one gathered sendmsg; at most one send per connection is in flight
+void UringReactor::startSend(Loop& loop, Connection& conn) {
+    std::lock_guard<std::mutex> lock(conn.outputLock);
+    conn.flushQueued = false;
+    if (conn.tornDown || !conn.sending.empty() || conn.output.empty()) {
+        return;
+    }
+    std::swap(conn.sending, conn.output);
+    submitSend(loop, conn, 0);
+}
+
+void UringReactor::handleCompletion(Loop& loop, const io_uring_cqe& cqe) {
+    Connection* conn = reinterpret_cast<Connection*>(cqe.user_data & ~OP_MASK);
+    switch (cqe.user_data & OP_MASK) {
+    case OP_WAKE:
+        if (running) {
+            armWake(loop);
+        }
+        break;
+    case OP_ACCEPT:
+        handleAccept(loop, *conn, cqe);
+        break;
+    case OP_RECV:
+        handleRecv(loop, *conn, cqe);
+        finishIfIdle(loop, *conn);
+        break;
+    case OP_SEND:
+        handleSend(loop, *conn, cqe);
+        finishIfIdle(loop, *conn);
+        break;
+    case OP_SWEEP:
+        evictStalled(loop.index);
+        if (running) {
+            armSweep(loop);
+        }
+        break;
+    default:
+        break;
+    }
+}
+
+void UringReactor::handleAccept(Loop& loop, Connection& listener, const io_uring_cqe& cqe) {
+    if (cqe.res >= 0) {
+        auto conn = std::make_shared<Connection>(cqe.res, listener.type, false, loop.index);
+        tuneSocket(conn->fd);
+        registerConnection(conn);
+        handler.onOpen(*conn);
+        loop.owned[conn.get()] = conn;
+        armRecv(loop, *conn);
+    } else if (cqe.res != -ECANCELED) {
+        LOG_ERROR(NET, "Accept failed: " << strerror(-cqe.res));
+    }
+    if (!(cqe.flags & IORING_CQE_F_MORE) && running) {
+        armAccept(loop, listener);
+    }
+}
+
+void UringReactor::handleRecv(Loop& loop, Connection& conn, const io_uring_cqe& cqe) {
+    bool more = (cqe.flags & IORING_CQE_F_MORE) != 0;
+    if (!more) {
+        conn.recvArmed = false;
+        conn.pendingOps--;
+    }
+
+    if (cqe.res > 0 && (cqe.flags & IORING_CQE_F_BUFFER)) {
+        unsigned bufferId = cqe.flags >> IORING_CQE_BUFFER_SHIFT;
+        const char* data = loop.buffers + static_cast<size_t>(bufferId) * BUFFER_SIZE;
+        conn.input.append(data, cqe.res);
+        recycleBuffer(loop, bufferId);
+        if (!conn.tornDown && !conn.closing) {
+            handler.onData(conn);
+            // Every buffer is handed over as it arrives, so input this full never makes a message
+            if (!conn.closing && conn.input.size() >= handler.inputLimit(conn)) {
+                LOG_WARN(NET, "Disconnecting fd=" << conn.fd << ": " << conn.input.size()
+                              << " bytes received without a complete message");
+                std::lock_guard<std::mutex> lock(conn.outputLock);
+                requestClose(conn);
+            }
+        }
+    }
+
+    if (cqe.res == 0 || (cqe.res < 0 && cqe.res != -ENOBUFS)) {
+        teardown(loop, conn);   // EOF, error or a requested close
+    } else if (!more && !conn.tornDown) {
+        armRecv(loop, conn);    // Ran out of provided buffers or the kernel ended the multishot
+    }
+}
+
+void UringReactor::handleSend(Loop& loop, Connection& conn, const io_uring_cqe& cqe) {
+    conn.pendingOps--;
+    std::lock_guard<std::mutex> lock(conn.outputLock);
+    if (cqe.res < 0) {
+        conn.sending.clear();
+        requestClose(conn);
+        return;
+    }
+    conn.sending.consume(cqe.res);
+    if (cqe.res > 0) {
+        conn.backlogSince = std::chrono::steady_clock::now();
+    }
+    if (!conn.sending.empty() && (!conn.tornDown || cqe.res > 0)) {
+        // Short send, or more than one call's worth of segments; after teardown only while the
+        // best-effort send keeps making progress
+        submitSend(loop, conn, conn.tornDown ? MSG_DONTWAIT : 0);
+        return;
+    }
+    conn.sending.clear();
+    if (!conn.tornDown && !conn.output.empty()) {
+        std::swap(conn.sending, conn.output);
+        submitSend(loop, conn, 0);
+    }
+}
+
+void UringReactor::teardown(Loop& loop, Connection& conn) {
+    if (conn.tornDown) {
+        return;
+    }
+    conn.tornDown = true;
+    std::shared_ptr<Connection> keep = unregisterConnection(conn.fd);
+    handler.onClose(conn);
+
+    std::lock_guard<std::mutex> lock(conn.outputLock);
+    conn.closing = true;
+    if (!conn.sending.empty()) {
+        // A send still blocked on a slow peer would keep the connection alive indefinitely
+        shutdown(conn.fd, SHUT_RDWR);
+    } else if (!conn.output.empty()) {
+        // Best effort for anything queued before the close (e.g. an error reply)
+        std::swap(conn.sending, conn.output);
+        submitSend(loop, conn, MSG_DONTWAIT);
+    }
+}
+
+// Closing the fd has to wait for the last completion that refers to the connection
+void UringReactor::finishIfIdle(Loop& loop, Connection& conn) {
+    if (!conn.tornDown || conn.pendingOps > 0) {
+        return;
+    }
+    {
+        std::lock_guard<std::mutex> lock(conn.outputLock);
+        if (conn.closed) {
+            return;
+        }
+        ::close(conn.fd);
+        conn.closed = true;
+    }
+    loop.owned.erase(&conn);   // May free the connection
+}
+
+void UringReactor::loop(Loop& loop) {
+    currentLoop = &loop;
+    armWake(loop);
+    loop.sweepInterval.tv_sec = SWEEP_INTERVAL_MS / 1000;
+    loop.sweepInterval.tv_nsec = (SWEEP_INTERVAL_MS % 1000) * 1000000L;
+    armSweep(loop);
+    for (auto& listener : listeners) {
+        armAccept(loop, *listener);
+    }
+
+    std::vector<std::shared_ptr<Connection>> adopted;
+    std::vector<std::shared_ptr<Connection>> flushes;
+    while (running) {
+        // Everything queued since the last pass goes to the kernel in one io_uring_enter
+        loop.wakePending = false;
+        {
+            std::lock_guard<std::mutex> lock(loop.pendingLock);
+            adopted.swap(loop.pendingAdopt);
+            flushes.swap(loop.pendingFlush);
+        }
+        for (auto& conn : adopted) {
+            loop.owned[conn.get()] = conn;
+            armRecv(loop, *conn);
+        }
+        for (auto& conn : flushes) {
+            startSend(loop, *conn);
+        }
+        adopted.clear();
+        flushes.clear();
+
+        int ret = loop.ring->submit(1);
+        if (ret < 0 && ret != -EAGAIN && ret != -EBUSY) {
+            LOG_ERROR(NET, "io_uring_enter failed: " << strerror(-ret));
+            break;
+        }
+
+        // Only what has arrived so far, so the handlers' own submissions are not held back
+        size_t ready = loop.ring->cqTailIndex() - loop.ring->cqHeadIndex();
+        ready += loop.stashed.size() - loop.stashedNext;
+        io_uring_cqe cqe;
+        for (; ready > 0 && nextCompletion(loop, cqe); ready--) {
+            handleCompletion(loop, cqe);
+        }
+    }
+    currentLoop = nullptr;
+}
+
+void UringReactor::run() {
+    running = true;
+    for (int i = 1; i < getNumThreads(); i++) {
+        threads.emplace_back(&UringReactor::loop, this, std::ref(*loops[i]));
+    }
+    loop(*loops[0]);
+    for (auto& thread : threads) {
+        thread.join();
+    }
+    threads.clear();
+}
+
+void UringReactor::stop() {
+    running = false;
+    for (auto& loop : loops) {
+        uint64_t one = 1;
+        ssize_t ignored = write(loop->wakeFd, &one, sizeof(one));
+        (void)ignored;
+    }
+}
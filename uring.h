@@ -0,0 +1,111 @@
+#ifndef URING_H
+#define URING_H
+
+#include "reactor.h"
+#include <linux/io_uring.h>
+
+// Minimal io_uring submission/completion ring over the raw syscalls (no liburing dependency)
+class IoRing {
+public:
+    explicit IoRing(unsigned entries);
+    ~IoRing();
+    IoRing(const IoRing&) = delete;
+    IoRing& operator=(const IoRing&) = delete;
+
+    // Zeroed SQE at the tail of the submission queue; submits first if the queue is full, and
+    // returns nullptr if the kernel still has not taken anything (it wants completions reaped)
+    io_uring_sqe* getSqe();
+    // Submit everything queued since the last call and wait for at least waitFor completions
+    int submit(unsigned waitFor);
+    // Register a provided-buffer ring (entries a power of two, memory page-aligned) as group
+    void registerBufferRing(io_uring_buf_ring* bufferRing, unsigned entries, unsigned group);
+
+    // Completions are consumed in order: peek, handle, then advance past the batch
+    unsigned cqHeadIndex() const { return cqLocalHead; }
+    io_uring_cqe* cqe(unsigned index) { return &cqes[index & *cqMask]; }
+    unsigned cqTailIndex() const { return __atomic_load_n(cqTail, __ATOMIC_ACQUIRE); }
+    void advanceCq(unsigned newHead) { cqLocalHead = newHead; __atomic_store_n(cqHead, newHead, __ATOMIC_RELEASE); }
+
+private:
+    int ringFd;
+    void* ringPtr;
+    size_t ringSize;
+    io_uring_sqe* sqes;
+    size_t sqesSize;
+    unsigned sqEntries;
+    unsigned* sqHead;
+    unsigned* sqTail;
+    unsigned* sqMask;
+    unsigned sqLocalTail;
+    unsigned toSubmit;
+    unsigned* cqHead;
+    unsigned* cqTail;
+    unsigned* cqMask;
+    unsigned cqLocalHead;
+    io_uring_cqe* cqes;
+};
+
+// io_uring backend. Each loop thread owns a ring with multishot accept on every listening socket
+// and a multishot recv per connection drawing from a per-loop ring of provided buffers, so receiving
+// needs no per-connection buffers and no re-arming syscalls; a used buffer goes back by bumping the
+// ring tail, with no SQE or syscall. Sends from any thread are queued to the owning loop and
+// submitted together, so a whole broadcast costs one io_uring_enter.
+class UringReactor : public Reactor {
+public:
+    UringReactor(ConnectionHandler& handler, const ServerConfig& config);
+    ~UringReactor() override;
+
+    void listen(int fd, ClientType type) override;
+    void adopt(int fd, ClientType type) override;
+    using Reactor::send;
+    bool send(int fd, OutboundMessage message) override;
+    void close(int fd) override;
+    void run() override;
+    void stop() override;
+    const char* name() const override { return "io_uring"; }
+
+private:
+    struct Loop {
+        int index;
+        std::unique_ptr<IoRing> ring;
+        int wakeFd;
+        uint64_t wakeValue;
+        __kernel_timespec sweepInterval;
+        char* buffers;                  // BUFFER_COUNT receive buffers provided to the kernel
+        io_uring_buf_ring* bufferRing;  // Shared with the kernel, which consumes from the head
+        uint16_t bufferTail;            // Next slot to refill; published through bufferRing->tail
+        std::mutex pendingLock;
+        std::vector<std::shared_ptr<Connection>> pendingAdopt;
+        std::vector<std::shared_ptr<Connection>> pendingFlush;
+        std::atomic<bool> wakePending;
+        std::unordered_map<Connection*, std::shared_ptr<Connection>> owned;
+        // Completions taken off the ring early to make room for submissions; handled first
+        std::vector<io_uring_cqe> stashed;
+        size_t stashedNext = 0;
+    };
+
+    void loop(Loop& loop);
+    void probeMultishotRecv(Loop& loop);
+    io_uring_sqe* nextSqe(Loop& loop);
+    bool nextCompletion(Loop& loop, io_uring_cqe& cqe);
+    void armWake(Loop& loop);
+    void armSweep(Loop& loop);
+    void armAccept(Loop& loop, Connection& listener);
+    void armRecv(Loop& loop, Connection& conn);
+    void startSend(Loop& loop, Connection& conn);
+    void submitSend(Loop& loop, Connection& conn, int flags);
+    void recycleBuffer(Loop& loop, unsigned bufferId);
+    void handleCompletion(Loop& loop, const io_uring_cqe& cqe);
+    void handleRecv(Loop& loop, Connection& conn, const io_uring_cqe& cqe);
+    void handleSend(Loop& loop, Connection& conn, const io_uring_cqe& cqe);
+    void handleAccept(Loop& loop, Connection& listener, const io_uring_cqe& cqe);
+    void teardown(Loop& loop, Connection& conn);
+    void finishIfIdle(Loop& loop, Connection& conn);
+    void wake(Loop& loop);
+
+    std::vector<std::unique_ptr<Loop>> loops;
+    std::vector<std::thread> threads;
+    std::atomic<unsigned> nextLoop;
+};
+
+#endif // URING_H
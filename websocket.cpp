@@ -0,0 +1,95 @@
+#include "websocket.h"
+#include <cstring>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#endif
+
+#if defined(__x86_64__) && (defined(__GNUC__) || defined(__clang__))
+#define WS_HAVE_AVX2 1
+#endif
+
+size_t writeWebSocketHeader(char* out, uint64_t payloadLength, bool binary, bool compressed) {
+    out[0] = static_cast<char>((binary ? 0x82 : 0x81) | (compressed ? 0x40 : 0));
+    if (payloadLength < 126) {
+        out[1] = static_cast<char>(payloadLength);
+        return 2;
+    }
+    if (payloadLength < 65536) {
+        out[1] = 126;
+        out[2] = static_cast<char>((payloadLength >> 8) & 0xFF);
+        out[3] = static_cast<char>(payloadLength & 0xFF);
+        return 4;
+    }
+    out[1] = 127;
+    for (int i = 0; i < 8; i++) {
+        out[2 + i] = static_cast<char>((payloadLength >> ((7 - i) * 8)) & 0xFF);
+    }
+    return 10;
+}
+
+// Every block below is a multiple of 4 bytes, so the key stays in phase with the payload and can
+// be repeated across a whole register. Loads and stores are unaligned: payloads start anywhere.
+
+static size_t unmaskWords(unsigned char* data, size_t length, uint32_t key) {
+    uint64_t key64 = (static_cast<uint64_t>(key) << 32) | key;
+    size_t i = 0;
+    for (; i + 8 <= length; i += 8) {
+        uint64_t word;
+        memcpy(&word, data + i, 8);
+        word ^= key64;
+        memcpy(data + i, &word, 8);
+    }
+    return i;
+}
+
+#if defined(__SSE2__)
+static size_t unmaskSse2(unsigned char* data, size_t length, uint32_t key) {
+    __m128i key128 = _mm_set1_epi32(static_cast<int>(key));
+    size_t i = 0;
+    for (; i + 16 <= length; i += 16) {
+        __m128i* block = reinterpret_cast<__m128i*>(data + i);
+        _mm_storeu_si128(block, _mm_xor_si128(_mm_loadu_si128(block), key128));
+    }
+    return i;
+}
+#endif
+
+#ifdef WS_HAVE_AVX2
+__attribute__((target("avx2")))
+static size_t unmaskAvx2(unsigned char* data, size_t length, uint32_t key) {
+    __m256i key256 = _mm256_set1_epi32(static_cast<int>(key));
+    size_t i = 0;
+    for (; i + 32 <= length; i += 32) {
+        __m256i* block = reinterpret_cast<__m256i*>(data + i);
+        _mm256_storeu_si256(block, _mm256_xor_si256(_mm256_loadu_si256(block), key256));
+    }
+    return i;
+}
+#endif
+
+void unmaskPayload(unsigned char* data, size_t length, const unsigned char mask[4]) {
+    uint32_t key;
+    memcpy(&key, mask, 4);
+
+    size_t done;
+#ifdef WS_HAVE_AVX2
+    static const bool avx2 = __builtin_cpu_supports("avx2");
+    if (avx2) {
+        done = unmaskAvx2(data, length, key);
+    } else
+#endif
+    {
+#if defined(__SSE2__)
+        done = unmaskSse2(data, length, key);
+#else
+        done = unmaskWords(data, length, key);
+#endif
+    }
+
+    // What is left of a register width: 8 bytes at a time, then single bytes
+    done += unmaskWords(data + done, length - done, key);
+    for (size_t i = done; i < length; i++) {
+        data[i] ^= mask[i % 4];
+    }
+}
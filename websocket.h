@@ -0,0 +1,18 @@
+#ifndef WEBSOCKET_H
+#define WEBSOCKET_H
+
+#include <cstddef>
+#include <cstdint>
+
+// Longest header a server frame can need (64-bit payload length; servers never mask)
+const size_t WS_MAX_HEADER = 10;
+
+// Writes the header of a final, unmasked text or binary frame to out; returns its length.
+// compressed sets RSV1, which marks a permessage-deflate message.
+size_t writeWebSocketHeader(char* out, uint64_t payloadLength, bool binary, bool compressed = false);
+
+// XOR a client's masking key over a payload in place. Runs 32 bytes at a time with AVX2 where the
+// CPU has it, 16 with SSE2 otherwise, and 8 on other targets, with a byte loop for the tail.
+void unmaskPayload(unsigned char* data, size_t length, const unsigned char mask[4]);
+
+#endif // WEBSOCKET_H